@@ -0,0 +1,214 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "interner.h"
+
+//shared interner throughput as the thread count doubles, every thread interns every name starting from its own place in the list
+//the add pass starts from an empty interner so threads race to add the same names, the lookup pass finds them all already interned
+//the indices each thread gets are checked against each other so a run is also a test of the interner
+//usage: interner_bench [--names count] [--repetitions count] [--threads count]
+
+#define DEFAULT_NAME_COUNT (1024 * 1024)
+#define DEFAULT_REPETITIONS 5
+#define DEFAULT_MAX_THREAD_COUNT 16
+
+/*
+
+name generation
+
+*/
+
+typedef struct {
+	char* data;
+	size_t* offsets; //name i is data + offsets[i] up to offsets[i + 1]
+	size_t count;
+} Names;
+
+//xorshift so names are the same on every run and platform
+static uint32_t random_state = 2463534242u;
+static uint32_t nextRandom(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+//identifier shaped names that are all different, sharing prefixes like real ones do
+static Names generateNames(size_t count) {
+	static const char* const words[] = {
+		"value", "index", "count", "buffer_length", "node", "next_node", "result", "accumulator",
+		"i", "j", "x", "width", "height", "compilation_unit", "token_list", "current_scope",
+	};
+	const size_t word_count = sizeof(words) / sizeof(words[0]);
+
+	Names names = {0};
+	names.count = count;
+	names.data = malloc(count * 48);
+	names.offsets = malloc((count + 1) * sizeof(size_t));
+	if (names.data == NULL || names.offsets == NULL) {
+		printf("ERROR: Failed to allocate %zu benchmark names!\n", count);
+		exit(1);
+	}
+
+	size_t length = 0;
+	for (size_t i = 0; i < count; ++i) {
+		names.offsets[i] = length;
+		length += sprintf(names.data + length, "%s_%s%zu", words[nextRandom() % word_count], words[nextRandom() % word_count], i);
+	}
+	names.offsets[count] = length;
+	return names;
+}
+
+/*
+
+measurement
+
+*/
+
+typedef struct {
+	Interner* interner;
+	const Names* names;
+	size_t* indices; //SIZE_MAX until the first thread to intern a name records its index
+	size_t first_name;
+	size_t mismatch_count;
+} Worker;
+
+static void* internNames(void* argument) {
+	Worker* worker = argument;
+	const Names* names = worker->names;
+	for (size_t i = 0; i < names->count; ++i) {
+		size_t name = (worker->first_name + i) % names->count;
+		const char* identifier = names->data + names->offsets[name];
+		size_t index = interner_getOrAddIndex(worker->interner, identifier, names->offsets[name + 1] - names->offsets[name]);
+
+		size_t expected = SIZE_MAX;
+		if (!__atomic_compare_exchange_n(&worker->indices[name], &expected, index, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) && expected != index) {
+			++worker->mismatch_count;
+		}
+	}
+	return NULL;
+}
+
+static double secondsNow(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+	double difference = *(const double*)a - *(const double*)b;
+	return (difference > 0) - (difference < 0);
+}
+
+//every thread interns every name once, returns the seconds taken
+static double timeInterning(Interner* interner, const Names* names, size_t* indices, size_t thread_count) {
+	Worker workers[thread_count];
+	pthread_t threads[thread_count];
+
+	double start = secondsNow();
+	for (size_t i = 0; i < thread_count; ++i) {
+		workers[i] = (Worker){.interner=interner, .names=names, .indices=indices, .first_name=names->count / thread_count * i};
+		if (pthread_create(&threads[i], NULL, internNames, &workers[i]) != 0) {
+			printf("ERROR: Failed to create benchmark thread!\n");
+			exit(1);
+		}
+	}
+	for (size_t i = 0; i < thread_count; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	double seconds = secondsNow() - start;
+
+	for (size_t i = 0; i < thread_count; ++i) {
+		if (workers[i].mismatch_count != 0) {
+			printf("ERROR: Threads got different indices for the same name!\n");
+			exit(1);
+		}
+	}
+	return seconds;
+}
+
+//indices must be dense and each must give back the name it was handed out for
+static void checkInterner(const Interner* interner, const Names* names, const size_t* indices) {
+	if (interner_count(interner) != names->count) {
+		printf("ERROR: Interner holds %zu names instead of %zu!\n", interner_count(interner), names->count);
+		exit(1);
+	}
+	for (size_t i = 0; i < names->count; ++i) {
+		const char* identifier = interner_getIdentifier(interner, indices[i]);
+		size_t length = names->offsets[i + 1] - names->offsets[i];
+		if (indices[i] >= names->count || strlen(identifier) != length || memcmp(identifier, names->data + names->offsets[i], length) != 0) {
+			printf("ERROR: Interner index %zu does not give back its name!\n", indices[i]);
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	//handle command line arguments
+	size_t name_count = DEFAULT_NAME_COUNT;
+	size_t repetitions = DEFAULT_REPETITIONS;
+	size_t max_thread_count = DEFAULT_MAX_THREAD_COUNT;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		size_t value = strtoull(argv[i + 1], NULL, 10);
+		if (strcmp(argv[i], "--names") == 0) {
+			name_count = value;
+		} else if (strcmp(argv[i], "--repetitions") == 0) {
+			repetitions = value;
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			max_thread_count = value;
+		} else {
+			printf("ERROR: Unknown argument: %s!\n", argv[i]);
+			return 1;
+		}
+	}
+	if (argc % 2 == 0 || name_count == 0 || repetitions == 0 || max_thread_count == 0) {
+		printf("ERROR: Incorrect arguments!\n");
+		return 1;
+	}
+
+	Names names = generateNames(name_count);
+	size_t* indices = malloc(name_count * sizeof(size_t));
+	if (indices == NULL) {
+		printf("ERROR: Failed to allocate %zu benchmark indices!\n", name_count);
+		return 1;
+	}
+
+	printf("%-8s %14s %14s %14s %14s\n", "threads", "add Mop/s", "add speedup", "lookup Mop/s", "lookup speedup");
+	double base_add_rate = 0.0;
+	double base_lookup_rate = 0.0;
+	for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+		double add_seconds[repetitions];
+		double lookup_seconds[repetitions];
+		for (size_t i = 0; i < repetitions; ++i) {
+			Interner* interner = interner_create();
+			memset(indices, 0xff, name_count * sizeof(size_t));
+			add_seconds[i] = timeInterning(interner, &names, indices, thread_count);
+			lookup_seconds[i] = timeInterning(interner, &names, indices, thread_count);
+			checkInterner(interner, &names, indices);
+			interner_destroy(interner);
+		}
+		qsort(add_seconds, repetitions, sizeof(add_seconds[0]), compareDoubles);
+		qsort(lookup_seconds, repetitions, sizeof(lookup_seconds[0]), compareDoubles);
+
+		//operations are every name once per thread, taken at the median
+		double operations = (double)name_count * thread_count / 1e6;
+		double add_rate = operations / add_seconds[repetitions / 2];
+		double lookup_rate = operations / lookup_seconds[repetitions / 2];
+		if (thread_count == 1) {
+			base_add_rate = add_rate;
+			base_lookup_rate = lookup_rate;
+		}
+		printf("%-8zu %14.1f %14.2f %14.1f %14.2f\n", thread_count, add_rate, add_rate / base_add_rate, lookup_rate, lookup_rate / base_lookup_rate);
+	}
+
+	free(indices);
+	free(names.offsets);
+	free(names.data);
+	return 0;
+}
@@ -0,0 +1,235 @@
+#include <llvm-c/Core.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "compilation_unit.h"
+#include "tokeniser.h"
+
+//tokeniser throughput over synthetic corpora that each stress one path of the lexer
+//usage: lexer_bench [--size megabytes] [--repetitions count] [--threads count]
+
+#define DEFAULT_CORPUS_SIZE (16 * 1024 * 1024)
+#define DEFAULT_REPETITIONS 5
+#define WARM_UP_REPETITIONS 2
+
+/*
+
+corpus generation
+
+*/
+
+typedef struct {
+	char* data;
+	size_t length;
+	size_t capacity;
+} Corpus;
+
+static void corpusAppend(Corpus* corpus, const char* text) {
+	size_t length = strlen(text);
+	if (corpus->length + length > corpus->capacity) {
+		corpus->capacity = (corpus->length + length) * 2;
+		corpus->data = realloc(corpus->data, corpus->capacity);
+		if (corpus->data == NULL) {
+			printf("ERROR: Failed to grow benchmark corpus!\n");
+			exit(1);
+		}
+	}
+	memcpy(corpus->data + corpus->length, text, length);
+	corpus->length += length;
+}
+
+//xorshift so corpora are the same on every run and platform
+static uint32_t random_state = 2463534242u;
+static uint32_t nextRandom(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+static void generateIdentifiers(Corpus* corpus, size_t size) {
+	static const char* const words[] = {
+		"value", "index", "count", "buffer_length", "node", "next_node", "result", "accumulator",
+		"i", "j", "x", "width", "height", "compilation_unit", "token_list", "current_scope",
+	};
+	char line[128];
+	while (corpus->length < size) {
+		const char* left = words[nextRandom() % (sizeof(words) / sizeof(words[0]))];
+		const char* right = words[nextRandom() % (sizeof(words) / sizeof(words[0]))];
+		snprintf(line, sizeof(line), "%s_%u = %s;\n", left, nextRandom() % 512, right);
+		corpusAppend(corpus, line);
+	}
+}
+
+static void generateOperators(Corpus* corpus, size_t size) {
+	static const char* const operators[] = {
+		"+", "-", "*", "/", "%", "&", "|", "^", "<<", ">>", "==", "!=", "<=", ">=", "<", ">",
+		"+=", "-=", "<<=", ">>=", "->", "~~", "(", ")", "[", "]", "{", "}", ";", ",", ".",
+	};
+	while (corpus->length < size) {
+		corpusAppend(corpus, operators[nextRandom() % (sizeof(operators) / sizeof(operators[0]))]);
+		corpusAppend(corpus, nextRandom() % 4 == 0 ? "\n" : " ");
+	}
+}
+
+static void generateLiterals(Corpus* corpus, size_t size) {
+	char literal[64];
+	while (corpus->length < size) {
+		switch (nextRandom() % 5) {
+			case 0: snprintf(literal, sizeof(literal), "%u, ", nextRandom()); break;
+			case 1: snprintf(literal, sizeof(literal), "0x%x, ", nextRandom()); break;
+			case 2: snprintf(literal, sizeof(literal), "%u.%u, ", nextRandom() % 1000, nextRandom() % 100000); break;
+			case 3: snprintf(literal, sizeof(literal), "'%c', ", 'a' + nextRandom() % 26); break;
+			default: snprintf(literal, sizeof(literal), "0b%u%u%u%u, ", nextRandom() % 2, nextRandom() % 2, nextRandom() % 2, nextRandom() % 2); break;
+		}
+		corpusAppend(corpus, literal);
+		if (nextRandom() % 8 == 0) corpusAppend(corpus, "\n");
+	}
+}
+
+static void generateIndented(Corpus* corpus, size_t size) {
+	char indent[64];
+	while (corpus->length < size) {
+		size_t depth = nextRandom() % 48;
+		memset(indent, '\t', depth);
+		indent[depth] = '\0';
+		corpusAppend(corpus, indent);
+		corpusAppend(corpus, nextRandom() % 2 == 0 ? "if x {\n" : "}\n");
+		if (nextRandom() % 4 == 0) corpusAppend(corpus, "\n\n");
+	}
+}
+
+static void generateStrings(Corpus* corpus, size_t size) {
+	char text[4096];
+	while (corpus->length < size) {
+		size_t length = 256 + nextRandom() % (sizeof(text) - 256);
+		for (size_t i = 0; i < length; ++i) {
+			text[i] = 'a' + nextRandom() % 26;
+			if (nextRandom() % 16 == 0) text[i] = ' ';
+		}
+		text[length] = '\0';
+		corpusAppend(corpus, "s = \"");
+		corpusAppend(corpus, text);
+		corpusAppend(corpus, nextRandom() % 4 == 0 ? "\\n\";\n" : "\";\n");
+	}
+}
+
+typedef struct {
+	const char* name;
+	void (*generate)(Corpus* corpus, size_t size);
+} CorpusKind;
+
+static const CorpusKind CORPUS_KINDS[] = {
+	{"identifiers", generateIdentifiers},
+	{"operators", generateOperators},
+	{"literals", generateLiterals},
+	{"indented", generateIndented},
+	{"strings", generateStrings},
+};
+
+/*
+
+measurement
+
+*/
+
+static double secondsNow(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+	double difference = *(const double*)a - *(const double*)b;
+	return (difference > 0) - (difference < 0);
+}
+
+//lexes the file and walks the cursor to eof, returning the seconds taken and the token count
+static double timeTokenising(const char* path, LLVMContextRef llvm_context, size_t thread_count, size_t* token_count) {
+	CompilationUnit compilation_unit = compilationUnit_create(path, llvm_context);
+
+	double start = secondsNow();
+	if (thread_count > 1) {
+		tokeniseParallel(&compilation_unit, thread_count);
+	} else {
+		tokenise(&compilation_unit);
+	}
+	tokeniserSetTokens(&compilation_unit.token_list);
+	size_t count = 1;
+	while (currentTokenType() != TOKEN_EOF) {
+		incrementToken();
+		++count;
+	}
+	double seconds = secondsNow() - start;
+
+	*token_count = count;
+	compilationUnit_destroy(&compilation_unit);
+	return seconds;
+}
+
+int main(int argc, char* argv[]) {
+	//handle command line arguments
+	size_t corpus_size = DEFAULT_CORPUS_SIZE;
+	size_t repetitions = DEFAULT_REPETITIONS;
+	size_t thread_count = 1;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		size_t value = strtoull(argv[i + 1], NULL, 10);
+		if (strcmp(argv[i], "--size") == 0) {
+			corpus_size = value * 1024 * 1024;
+		} else if (strcmp(argv[i], "--repetitions") == 0) {
+			repetitions = value;
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			thread_count = value;
+		} else {
+			printf("ERROR: Unknown argument: %s!\n", argv[i]);
+			return 1;
+		}
+	}
+	if (argc % 2 == 0 || corpus_size == 0 || repetitions == 0) {
+		printf("ERROR: Incorrect arguments!\n");
+		return 1;
+	}
+
+	LLVMContextRef llvm_context = LLVMContextCreate();
+
+	printf("%-12s %10s %12s %12s %14s\n", "corpus", "size MB", "best MB/s", "median MB/s", "median tok/s");
+	for (size_t i = 0; i < sizeof(CORPUS_KINDS) / sizeof(CORPUS_KINDS[0]); ++i) {
+		//the tokeniser reads from a file so write each corpus out first
+		Corpus corpus = {0};
+		CORPUS_KINDS[i].generate(&corpus, corpus_size);
+
+		char path[] = "/tmp/lexer_bench_XXXXXX";
+		int file_descriptor = mkstemp(path);
+		if (file_descriptor < 0 || write(file_descriptor, corpus.data, corpus.length) != (ssize_t)corpus.length) {
+			printf("ERROR: Failed to write benchmark corpus %s!\n", CORPUS_KINDS[i].name);
+			return 1;
+		}
+		close(file_descriptor);
+
+		size_t token_count = 0;
+		for (size_t j = 0; j < WARM_UP_REPETITIONS; ++j) {
+			timeTokenising(path, llvm_context, thread_count, &token_count);
+		}
+		double seconds[repetitions];
+		for (size_t j = 0; j < repetitions; ++j) {
+			seconds[j] = timeTokenising(path, llvm_context, thread_count, &token_count);
+		}
+		qsort(seconds, repetitions, sizeof(seconds[0]), compareDoubles);
+		double median = seconds[repetitions / 2];
+
+		double megabytes = corpus.length / (1024.0 * 1024.0);
+		printf("%-12s %10.1f %12.1f %12.1f %14.0f\n",
+			CORPUS_KINDS[i].name, megabytes, megabytes / seconds[0], megabytes / median, token_count / median);
+
+		unlink(path);
+		free(corpus.data);
+	}
+
+	LLVMContextDispose(llvm_context);
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <llvm-c/Core.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "compilation_unit.h"
+#include "tokeniser.h"
+
+//incremental relexing speed of one character edits, as a language server sees while someone types
+//edits go inside a long string literal so each one lexes the whole literal again, the worst case for the side tables
+//the side tables must stop growing once the dead entries of replaced tokens are compacted away,
+//so the largest they get in the second half of the edits has to be no larger than in the first half
+//usage: retokenise_bench [--literal kilobytes] [--edits count]
+
+#define DEFAULT_LITERAL_SIZE (20 * 1024)
+#define DEFAULT_EDIT_COUNT 4000
+
+typedef struct {
+	size_t integer_count;
+	size_t real_count;
+	size_t string_count;
+	size_t string_data_length;
+} SideTableSizes;
+
+static void updatePeak(SideTableSizes* peak, const TokenList* token_list) {
+	if (token_list->integer_count > peak->integer_count) peak->integer_count = token_list->integer_count;
+	if (token_list->real_count > peak->real_count) peak->real_count = token_list->real_count;
+	if (token_list->string_count > peak->string_count) peak->string_count = token_list->string_count;
+	if (token_list->string_data_length > peak->string_data_length) peak->string_data_length = token_list->string_data_length;
+}
+
+static double secondsNow(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+int main(int argc, char* argv[]) {
+	//handle command line arguments
+	size_t literal_size = DEFAULT_LITERAL_SIZE;
+	size_t edit_count = DEFAULT_EDIT_COUNT;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		size_t value = strtoull(argv[i + 1], NULL, 10);
+		if (strcmp(argv[i], "--literal") == 0) {
+			literal_size = value * 1024;
+		} else if (strcmp(argv[i], "--edits") == 0) {
+			edit_count = value;
+		} else {
+			printf("ERROR: Unknown argument: %s!\n", argv[i]);
+			return 1;
+		}
+	}
+	if (argc % 2 == 0 || literal_size == 0 || edit_count < 2) {
+		printf("ERROR: Incorrect arguments!\n");
+		return 1;
+	}
+
+	//numbers around the literal so every side table has live entries
+	static const char prefix[] = "fn main() {\n\ta : i64 = 1;\n\tb : f64 = 2.5;\n\ts = \"";
+	static const char suffix[] = "\";\n\tc : i64 = 0x10;\n}\n";
+	size_t text_length = sizeof(prefix) - 1 + literal_size + sizeof(suffix) - 1;
+	char* text = malloc(text_length);
+	if (text == NULL) {
+		printf("ERROR: Failed to allocate benchmark source!\n");
+		return 1;
+	}
+	memcpy(text, prefix, sizeof(prefix) - 1);
+	for (size_t i = 0; i < literal_size; ++i) {
+		text[sizeof(prefix) - 1 + i] = 'a' + i % 26;
+	}
+	memcpy(text + sizeof(prefix) - 1 + literal_size, suffix, sizeof(suffix) - 1);
+
+	LLVMContextRef llvm_context = LLVMContextCreate();
+	CompilationUnit compilation_unit = compilationUnit_createFromText("retokenise_bench", text, text_length, llvm_context);
+	retokenise(&compilation_unit, 0, 0, compilation_unit.source_length);
+
+	//each edit overwrites one character of the literal in place and relexes around it
+	SideTableSizes first_half_peak = {0};
+	SideTableSizes second_half_peak = {0};
+	double start = secondsNow();
+	for (size_t i = 0; i < edit_count; ++i) {
+		size_t edit_offset = sizeof(prefix) - 1 + (i * 7919) % literal_size;
+		compilation_unit.source[edit_offset] = 'a' + i % 26;
+		retokenise(&compilation_unit, edit_offset, 1, 1);
+		updatePeak(i < edit_count / 2 ? &first_half_peak : &second_half_peak, &compilation_unit.token_list);
+	}
+	double seconds = secondsNow() - start;
+
+	printf("%zu edits in a %zu byte literal, %.0f edits/s\n", edit_count, literal_size, edit_count / seconds);
+	printf("peak side tables: %zu integers, %zu reals, %zu strings, %zu string bytes\n",
+		second_half_peak.integer_count, second_half_peak.real_count, second_half_peak.string_count, second_half_peak.string_data_length);
+	bool grew = second_half_peak.integer_count > first_half_peak.integer_count ||
+		second_half_peak.real_count > first_half_peak.real_count ||
+		second_half_peak.string_count > first_half_peak.string_count ||
+		second_half_peak.string_data_length > first_half_peak.string_data_length;
+	if (grew) {
+		printf("ERROR: Token list side tables kept growing with repeated edits!\n");
+		return 1;
+	}
+
+	compilationUnit_destroy(&compilation_unit);
+	LLVMContextDispose(llvm_context);
+	free(text);
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "arena.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//allocations larger than this get a block of their own size
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ArenaBlock {
+	ArenaBlock* previous;
+	size_t used;
+	size_t capacity;
+	max_align_t data[]; //capacity bytes
+};
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void addBlock(Arena* arena, size_t minimum_capacity) {
+	size_t capacity = minimum_capacity > ARENA_BLOCK_SIZE ? minimum_capacity : ARENA_BLOCK_SIZE;
+	ArenaBlock* block = malloc(sizeof(ArenaBlock) + capacity);
+	if (block == NULL) {
+		printf("ERROR: Failed to allocate %zu byte arena block!\n", capacity);
+		exit(1);
+	}
+
+	block->previous = arena->current;
+	block->used = 0;
+	block->capacity = capacity;
+	arena->current = block;
+}
+
+void* arena_allocate(Arena* arena, size_t size, size_t alignment) {
+	ArenaBlock* block = arena->current;
+	if (block != NULL) {
+		size_t start = alignUp(block->used, alignment);
+		if (start <= block->capacity && size <= block->capacity - start) {
+			block->used = start + size;
+			return (char*)block->data + start;
+		}
+	}
+
+	//block data is aligned for any type so a new block can always start at 0
+	addBlock(arena, size);
+	arena->current->used = size;
+	return arena->current->data;
+}
+
+void* arena_reallocate(Arena* arena, void* allocation, size_t old_size, size_t new_size, size_t alignment) {
+	if (allocation == NULL) return arena_allocate(arena, new_size, alignment);
+
+	//the last allocation of the newest block can grow in place
+	//compared as integers since allocation may be in another block
+	ArenaBlock* block = arena->current;
+	uintptr_t block_end = (uintptr_t)((char*)block->data + block->used);
+	if ((uintptr_t)allocation + old_size == block_end) {
+		size_t start = block->used - old_size;
+		if (new_size <= block->capacity - start) {
+			block->used = start + new_size;
+			return allocation;
+		}
+	}
+
+	void* new_allocation = arena_allocate(arena, new_size, alignment);
+	memcpy(new_allocation, allocation, old_size < new_size ? old_size : new_size);
+	return new_allocation;
+}
+
+char* arena_copyString(Arena* arena, const char* text, size_t length) {
+	char* copy = arena_allocate(arena, length + 1, 1); //+1 for null character
+	memcpy(copy, text, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+void arena_getUsage(const Arena* arena, size_t* block_count, size_t* reserved_bytes, size_t* used_bytes) {
+	*block_count = 0;
+	*reserved_bytes = 0;
+	*used_bytes = 0;
+	for (const ArenaBlock* block = arena->current; block != NULL; block = block->previous) {
+		++*block_count;
+		*reserved_bytes += sizeof(ArenaBlock) + block->capacity;
+		*used_bytes += block->used;
+	}
+}
+
+void arena_reset(Arena* arena) {
+	ArenaBlock* block = arena->current;
+	if (block == NULL) return;
+
+	ArenaBlock* previous = block->previous;
+	while (previous != NULL) {
+		ArenaBlock* next = previous->previous;
+		free(previous);
+		previous = next;
+	}
+	block->previous = NULL;
+	block->used = 0;
+}
+
+void arena_destroy(Arena* arena) {
+	arena_reset(arena);
+	free(arena->current);
+	arena->current = NULL;
+}
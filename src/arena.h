@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+
+//bump pointer allocator, memory is handed out in order from large blocks and only given back all at once
+//an arena that is all zero is empty and ready to use
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+	ArenaBlock* current; //newest block, older ones are reached through it
+} Arena;
+
+//never returns NULL, contents are uninitialised
+void* arena_allocate(Arena* arena, size_t size, size_t alignment);
+//allocation must have come from arena with old_size bytes, it is grown in place if nothing was allocated after it
+//otherwise the contents are copied to a new allocation and the old one is abandoned
+void* arena_reallocate(Arena* arena, void* allocation, size_t old_size, size_t new_size, size_t alignment);
+//null-terminated copy of text, which does not need to be
+char* arena_copyString(Arena* arena, const char* text, size_t length);
+
+//walks the blocks, reserved_bytes counts what was taken from malloc and used_bytes what was handed out of it
+void arena_getUsage(const Arena* arena, size_t* block_count, size_t* reserved_bytes, size_t* used_bytes);
+
+//gives back every allocation but keeps the newest block for reuse
+void arena_reset(Arena* arena);
+void arena_destroy(Arena* arena);
@@ -1,12 +1,36 @@
 #include "compilation_unit.h"
 
+#include <fcntl.h>
 #include <llvm-c/Core.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define INITIAL_LIST_CAPACITY 1
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "interface_file.h"
+
+#define INITIAL_LIST_CAPACITY 4
+#define INITIAL_IDENTIFIER_TABLE_CAPACITY 64
+
+//in the order of their TYPE_INDEX defines
+static const VariableType BUILTIN_TYPES[] = {
+	[TYPE_INDEX_NONE] = {.kind=TYPE_NONE},
+	[TYPE_INDEX_VOID] = {.kind=TYPE_VOID},
+	[TYPE_INDEX_BOOL] = {.kind=TYPE_BOOL, .data.width=1},
+	[TYPE_INDEX_CHAR] = {.kind=TYPE_CHAR, .data.width=32},
+	[TYPE_INDEX_INT] = {.kind=TYPE_INT, .data.width=64},
+	[TYPE_INDEX_FLOAT] = {.kind=TYPE_FLOAT, .data.width=64},
+	[TYPE_INDEX_STRING] = {.kind=TYPE_STRUCT, .data.struct_type=NULL},
+	[TYPE_INDEX_BOOL_LITERAL] = {.kind=TYPE_CHAR, .data.width=1},
+};
+
+//forward declarations
+static void addBuiltinTypes(CompilationUnit* compilation_unit);
+static void closeImports(CompilationUnit* compilation_unit);
 
 /*
 
@@ -14,7 +38,33 @@ creation/destruction
 
 */
 
-CompilationUnit compilationUnit_create(const char* source_path, LLVMContextRef llvm_context) {
+//reads the whole regular file in one go, result is followed by SOURCE_PADDING zero bytes
+static char* loadSource(int file_descriptor, const char* source_path, size_t file_size, size_t* source_length) {
+	char* source = malloc(file_size + SOURCE_PADDING);
+	if (source == NULL) {
+		printf("ERROR: Failed to allocate %zu bytes for source file %s!\n", file_size + SOURCE_PADDING, source_path);
+		exit(1);
+	}
+
+	//read may return early so loop until everything has arrived
+	size_t bytes_read = 0;
+	while (bytes_read < file_size) {
+		ssize_t read_result = read(file_descriptor, source + bytes_read, file_size - bytes_read);
+		if (read_result < 0) {
+			printf("ERROR: Failed to read source file: %s!\n", source_path);
+			exit(1);
+		}
+		if (read_result == 0) break; //file shrank since fstat
+		bytes_read += read_result;
+	}
+
+	memset(source + bytes_read, 0, SOURCE_PADDING);
+	*source_length = bytes_read;
+	return source;
+}
+
+//everything but the source
+static CompilationUnit createWithoutSource(const char* source_path, LLVMContextRef llvm_context) {
 	//initialise compilation unit
 	CompilationUnit compilation_unit;
 	memset(&compilation_unit, 0, sizeof(compilation_unit));
@@ -28,13 +78,6 @@ CompilationUnit compilationUnit_create(const char* source_path, LLVMContextRef l
 	}
 	strcpy(compilation_unit.source_path, source_path);
 
-	//open source file
-	compilation_unit.source_file = fopen(source_path, "r");
-	if (compilation_unit.source_file == NULL) {
-		printf("ERROR: Failed to open source file: %s!\n", source_path);
-		exit(1);
-	}
-
 	//setup llvm
 	compilation_unit.llvm_context = llvm_context;
 	compilation_unit.llvm_module = LLVMModuleCreateWithNameInContext(
@@ -46,39 +89,56 @@ CompilationUnit compilationUnit_create(const char* source_path, LLVMContextRef l
 		exit(1);
 	}
 
-	//initialise lists
-	//identifiers
-	compilation_unit.identifier_capacity = INITIAL_LIST_CAPACITY;
-	size_t identifiers_size = sizeof(compilation_unit.identifiers[0]) * INITIAL_LIST_CAPACITY;
-	compilation_unit.identifiers = malloc(identifiers_size);
-	if (compilation_unit.identifiers == NULL) {
-		printf("ERROR: Failed to allocate memory for compilation unit identifiers!\n");
+	//lists start empty and are allocated from the arenas as they grow
+	//identifier table, every byte UINT32_MAX marks every slot empty
+	compilation_unit.identifier_table_capacity = INITIAL_IDENTIFIER_TABLE_CAPACITY;
+	size_t identifier_table_size = sizeof(compilation_unit.identifier_table[0]) * INITIAL_IDENTIFIER_TABLE_CAPACITY;
+	compilation_unit.identifier_table = arena_allocate(&compilation_unit.identifier_arena, identifier_table_size, _Alignof(IdentifierSlot));
+	memset(compilation_unit.identifier_table, 0xff, identifier_table_size);
+	addBuiltinTypes(&compilation_unit);
+
+	compilation_unit.source_descriptor = -1;
+	return compilation_unit;
+}
+
+CompilationUnit compilationUnit_create(const char* source_path, LLVMContextRef llvm_context) {
+	CompilationUnit compilation_unit = createWithoutSource(source_path, llvm_context);
+
+	//open source file, "-" is standard input
+	int file_descriptor = strcmp(source_path, "-") == 0 ? STDIN_FILENO : open(source_path, O_RDONLY);
+	if (file_descriptor < 0) {
+		printf("ERROR: Failed to open source file: %s!\n", source_path);
+		exit(1);
 	}
-	memset(compilation_unit.identifiers, 0, identifiers_size);
-	//structs
-	compilation_unit.struct_capacity = INITIAL_LIST_CAPACITY;
-	size_t structs_size = sizeof(compilation_unit.structs[0]) * INITIAL_LIST_CAPACITY;
-	compilation_unit.structs = malloc(structs_size);
-	if (compilation_unit.structs == NULL) {
-		printf("ERROR: Failed to allocate memory for compilation unit structs!\n");
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0) {
+		printf("ERROR: Failed to get size of source file: %s!\n", source_path);
+		exit(1);
 	}
-	memset(compilation_unit.structs, 0, structs_size);
-	//variables
-	compilation_unit.global_variable_capacity = INITIAL_LIST_CAPACITY;
-	size_t variables_size = sizeof(compilation_unit.global_variables[0]) * INITIAL_LIST_CAPACITY;
-	compilation_unit.global_variables = malloc(variables_size);
-	if (compilation_unit.global_variables == NULL) {
-		printf("ERROR: Failed to allocate memory for compilation unit global variables!\n");
+
+	//load regular files whole, anything else such as a pipe has no known size and is streamed while tokenising
+	if (S_ISREG(file_status.st_mode)) {
+		compilation_unit.source = loadSource(file_descriptor, source_path, file_status.st_size, &compilation_unit.source_length);
+		close(file_descriptor);
+		compilation_unit.source_descriptor = -1;
+	} else {
+		compilation_unit.source_descriptor = file_descriptor;
 	}
-	memset(compilation_unit.global_variables, 0, variables_size);
-	//functions
-	compilation_unit.function_capacity = INITIAL_LIST_CAPACITY;
-	size_t functions_size = sizeof(compilation_unit.functions[0]) * INITIAL_LIST_CAPACITY;
-	compilation_unit.functions = malloc(functions_size);
-	if (compilation_unit.functions == NULL) {
-		printf("ERROR: Failed to allocate memory for compilation unit functions!\n");
+
+	return compilation_unit;
+}
+
+CompilationUnit compilationUnit_createFromText(const char* source_name, const char* text, size_t text_length, LLVMContextRef llvm_context) {
+	CompilationUnit compilation_unit = createWithoutSource(source_name, llvm_context);
+
+	compilation_unit.source = malloc(text_length + SOURCE_PADDING);
+	if (compilation_unit.source == NULL) {
+		printf("ERROR: Failed to allocate %zu bytes for source %s!\n", text_length + SOURCE_PADDING, source_name);
+		exit(1);
 	}
-	memset(compilation_unit.functions, 0, functions_size);
+	memcpy(compilation_unit.source, text, text_length);
+	memset(compilation_unit.source + text_length, 0, SOURCE_PADDING);
+	compilation_unit.source_length = text_length;
 
 	return compilation_unit;
 }
@@ -90,17 +150,81 @@ void compilationUnit_destroy(CompilationUnit* compilation_unit) {
 	free(compilation_unit->source_path);
 	compilation_unit->source_path = NULL;
 
-	if (compilation_unit->source_file != NULL) {
-		fclose(compilation_unit->source_file);
-		compilation_unit->source_file = NULL;
-	}
+	free(compilation_unit->source);
+	compilation_unit->source = NULL;
+	compilation_unit->source_length = 0;
+
+	if (compilation_unit->source_descriptor > STDIN_FILENO) close(compilation_unit->source_descriptor);
+	compilation_unit->source_descriptor = -1;
+
+	tokenList_destroy(&compilation_unit->token_list);
 
 	//dispose of llvm module and NULL llvm context
 	LLVMDisposeModule(compilation_unit->llvm_module);
 	compilation_unit->llvm_module = NULL;
 	compilation_unit->llvm_context = NULL;
 
-	//TODO free everything else
+	closeImports(compilation_unit);
+
+	//every list and identifier is in the arenas
+	arena_destroy(&compilation_unit->identifier_arena);
+	arena_destroy(&compilation_unit->declaration_arena);
+	compilation_unit->identifiers = NULL;
+	compilation_unit->identifier_count = 0;
+	compilation_unit->identifier_capacity = 0;
+	compilation_unit->identifier_table = NULL;
+	compilation_unit->identifier_table_capacity = 0;
+	compilation_unit->interner = NULL;
+	compilation_unit->types = NULL;
+	compilation_unit->type_count = 0;
+	compilation_unit->type_capacity = 0;
+	memset(&compilation_unit->structs, 0, sizeof(compilation_unit->structs));
+	memset(&compilation_unit->global_variables, 0, sizeof(compilation_unit->global_variables));
+	memset(&compilation_unit->functions, 0, sizeof(compilation_unit->functions));
+	memset(&compilation_unit->imported_structs, 0, sizeof(compilation_unit->imported_structs));
+	memset(&compilation_unit->imported_global_variables, 0, sizeof(compilation_unit->imported_global_variables));
+	memset(&compilation_unit->imported_functions, 0, sizeof(compilation_unit->imported_functions));
+	compilation_unit->top_level_symbols = NULL;
+	compilation_unit->top_level_symbol_capacity = 0;
+	memset(&compilation_unit->symbol_table, 0, sizeof(compilation_unit->symbol_table));
+}
+
+void compilationUnit_clearDeclarations(CompilationUnit* compilation_unit) {
+	closeImports(compilation_unit);
+	arena_reset(&compilation_unit->declaration_arena);
+	compilation_unit->types = NULL;
+	compilation_unit->type_count = 0;
+	compilation_unit->type_capacity = 0;
+	memset(&compilation_unit->structs, 0, sizeof(compilation_unit->structs));
+	memset(&compilation_unit->global_variables, 0, sizeof(compilation_unit->global_variables));
+	memset(&compilation_unit->functions, 0, sizeof(compilation_unit->functions));
+	memset(&compilation_unit->imported_structs, 0, sizeof(compilation_unit->imported_structs));
+	memset(&compilation_unit->imported_global_variables, 0, sizeof(compilation_unit->imported_global_variables));
+	memset(&compilation_unit->imported_functions, 0, sizeof(compilation_unit->imported_functions));
+	compilation_unit->top_level_symbols = NULL;
+	compilation_unit->top_level_symbol_capacity = 0;
+	memset(&compilation_unit->symbol_table, 0, sizeof(compilation_unit->symbol_table));
+	addBuiltinTypes(compilation_unit);
+
+	//llvm values of the declarations live in the module so start a new one
+	LLVMDisposeModule(compilation_unit->llvm_module);
+	compilation_unit->llvm_module = LLVMModuleCreateWithNameInContext(
+		compilation_unit->source_path,
+		compilation_unit->llvm_context
+	);
+	if (compilation_unit->llvm_module == NULL) {
+		printf("ERROR: Failed to create llvm module for compilation unit!\n");
+		exit(1);
+	}
+}
+
+void compilationUnit_setInterner(CompilationUnit* compilation_unit, Interner* interner) {
+	//indices already handed out would mean something else in the interner
+	if (compilation_unit->identifier_count != 0) {
+		printf("ERROR: Interner set after identifiers were added to %s!\n", compilation_unit->source_path);
+		exit(1);
+	}
+	compilation_unit->interner = interner;
 }
 
 /*
@@ -109,61 +233,141 @@ member list modification
 
 */
 
-size_t compilationUnit_getOrAddIdentifierIndex(CompilationUnit* compilation_unit, const char* identifier) {
-	//check if already in identifiers list
-	for (size_t i = 0; i < compilation_unit->identifier_count; ++i) {
-		//if strings are the same, return string pointer in identifiers list
-		int comparison_result = strcmp(identifier, compilation_unit->identifiers[i]);
-		if (comparison_result == 0) return i;
+//makes room for required_count elements in a list allocated from arena, doubling its capacity until they fit
+static void* reserveList(Arena* arena, void* list, size_t required_count, size_t* capacity, size_t element_size, size_t alignment) {
+	if (required_count <= *capacity) return list;
+
+	size_t new_capacity = *capacity == 0 ? INITIAL_LIST_CAPACITY : *capacity * 2;
+	while (new_capacity < required_count) new_capacity *= 2;
+	list = arena_reallocate(arena, list, *capacity * element_size, new_capacity * element_size, alignment);
+	*capacity = new_capacity;
+	return list;
+}
+
+//makes room for one more element
+static void* growList(Arena* arena, void* list, size_t count, size_t* capacity, size_t element_size, size_t alignment) {
+	return reserveList(arena, list, count + 1, capacity, element_size, alignment);
+}
+
+//fnv-1a
+static uint32_t hashIdentifier(const char* identifier, size_t identifier_length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < identifier_length; ++i) {
+		hash = (hash ^ (unsigned char)identifier[i]) * 16777619u;
+	}
+	return hash;
+}
+
+//slot holding the identifier, or the empty slot it would go in
+static IdentifierSlot* findIdentifierSlot(const CompilationUnit* compilation_unit, const char* identifier, size_t identifier_length, uint32_t hash) {
+	size_t mask = compilation_unit->identifier_table_capacity - 1;
+	//linear probing, the table is never more than half full so this always ends
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		IdentifierSlot* slot = compilation_unit->identifier_table + i;
+		if (slot->identifier_index == UINT32_MAX) return slot;
+		if (slot->hash == hash && slot->length == identifier_length &&
+			memcmp(compilation_unit->identifiers[slot->identifier_index], identifier, identifier_length) == 0) {
+			return slot;
+		}
 	}
+}
+
+static void growIdentifierTable(CompilationUnit* compilation_unit) {
+	IdentifierSlot* old_table = compilation_unit->identifier_table;
+	size_t old_capacity = compilation_unit->identifier_table_capacity;
+
+	//the old table is left in the arena, the tables before it add up to less than this one
+	size_t new_capacity = old_capacity * 2;
+	compilation_unit->identifier_table = arena_allocate(&compilation_unit->identifier_arena, new_capacity * sizeof(IdentifierSlot), _Alignof(IdentifierSlot));
+	memset(compilation_unit->identifier_table, 0xff, new_capacity * sizeof(IdentifierSlot));
+	compilation_unit->identifier_table_capacity = new_capacity;
+
+	//identifiers are all different so each only needs an empty slot
+	size_t mask = new_capacity - 1;
+	for (size_t i = 0; i < old_capacity; ++i) {
+		if (old_table[i].identifier_index == UINT32_MAX) continue;
+
+		size_t j = old_table[i].hash & mask;
+		while (compilation_unit->identifier_table[j].identifier_index != UINT32_MAX) j = (j + 1) & mask;
+		compilation_unit->identifier_table[j] = old_table[i];
+	}
+}
+
+//the unit's identifiers list is filled in at each index the first time the unit uses it
+static size_t getOrAddInternedIdentifierIndex(CompilationUnit* compilation_unit, const char* identifier, size_t identifier_length) {
+	size_t identifier_index = interner_getOrAddIndex(compilation_unit->interner, identifier, identifier_length);
+	if (identifier_index < compilation_unit->identifier_count && compilation_unit->identifiers[identifier_index] != NULL) return identifier_index;
+
+	//indices other units added in between are left NULL
+	size_t old_capacity = compilation_unit->identifier_capacity;
+	compilation_unit->identifiers = reserveList(&compilation_unit->identifier_arena, compilation_unit->identifiers, identifier_index + 1, &compilation_unit->identifier_capacity, sizeof(char*), _Alignof(char*));
+	memset(compilation_unit->identifiers + old_capacity, 0, (compilation_unit->identifier_capacity - old_capacity) * sizeof(char*));
+
+	//the interner never changes its strings, they are only non-const to match identifiers the unit owns
+	compilation_unit->identifiers[identifier_index] = (char*)interner_getIdentifier(compilation_unit->interner, identifier_index);
+	if (identifier_index >= compilation_unit->identifier_count) compilation_unit->identifier_count = identifier_index + 1;
+	return identifier_index;
+}
+
+size_t compilationUnit_getOrAddIdentifierIndex(CompilationUnit* compilation_unit, const char* identifier, size_t identifier_length) {
+	if (compilation_unit->interner != NULL) return getOrAddInternedIdentifierIndex(compilation_unit, identifier, identifier_length);
+
+	//check if already in identifiers list
+	uint32_t hash = hashIdentifier(identifier, identifier_length);
+	IdentifierSlot* slot = findIdentifierSlot(compilation_unit, identifier, identifier_length, hash);
+	if (slot->identifier_index != UINT32_MAX) return slot->identifier_index;
 
 	//not found in identifiers list
 	//add to identifiers list
+	if (identifier_length >= UINT32_MAX || compilation_unit->identifier_count >= UINT32_MAX - 1) {
+		printf("ERROR: Too many or too long identifiers in %s!\n", compilation_unit->source_path);
+		exit(1);
+	}
 
 	//if at capacity then double capacity
-	if (compilation_unit->identifier_count >= compilation_unit->identifier_capacity) {
-		//attempt to double size
-		size_t new_size = compilation_unit->identifier_capacity * sizeof(compilation_unit->identifiers[0]) * 2;
-		char** new_list = realloc(compilation_unit->identifiers, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		compilation_unit->identifiers = new_list;
-		compilation_unit->identifier_capacity *= 2;
-	}
+	compilation_unit->identifiers = growList(&compilation_unit->identifier_arena, compilation_unit->identifiers, compilation_unit->identifier_count, &compilation_unit->identifier_capacity, sizeof(char*), _Alignof(char*));
+	//copy string data
+	compilation_unit->identifiers[compilation_unit->identifier_count] = arena_copyString(&compilation_unit->identifier_arena, identifier, identifier_length);
 
-	//allocate memory and copy string data
-	char** new_identifier = compilation_unit->identifiers + compilation_unit->identifier_count;
-	size_t identifier_size = (strlen(identifier) + 1) * sizeof(char); //+1 for null character
+	slot->hash = hash;
+	slot->length = identifier_length;
+	slot->identifier_index = compilation_unit->identifier_count;
+	++compilation_unit->identifier_count;
 
-	*new_identifier = malloc(identifier_size);
-	strcpy(*new_identifier, identifier);
+	//keep the table at most half full
+	if (compilation_unit->identifier_count * 2 > compilation_unit->identifier_table_capacity) growIdentifierTable(compilation_unit);
 
-	++compilation_unit->identifier_count;
 	return compilation_unit->identifier_count - 1;
 }
 
-StructType* compilationUnit_addStructType(CompilationUnit* compilation_unit) {
+static bool typeMatches(VariableType t0, VariableType t1) {
+	if (t0.kind != t1.kind) return false;
+	if (t0.kind == TYPE_STRUCT) return t0.data.struct_type == t1.data.struct_type;
+	return t0.data.width == t1.data.width;
+}
+
+size_t compilationUnit_getOrAddTypeIndex(CompilationUnit* compilation_unit, VariableType type) {
+	for (size_t i = 0; i < compilation_unit->type_count; ++i) {
+		if (typeMatches(compilation_unit->types[i].type, type)) return i;
+	}
+
 	//if at capacity then double capacity
-	if (compilation_unit->struct_count >= compilation_unit->struct_capacity) {
-		//attempt to double size
-		size_t new_size = compilation_unit->struct_capacity * sizeof(compilation_unit->structs[0]) * 2;
-		StructType* new_list = realloc(compilation_unit->structs, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		compilation_unit->structs = new_list;
-		compilation_unit->struct_capacity *= 2;
+	compilation_unit->types = growList(&compilation_unit->declaration_arena, compilation_unit->types, compilation_unit->type_count, &compilation_unit->type_capacity, sizeof(InternedType), _Alignof(InternedType));
+	compilation_unit->types[compilation_unit->type_count] = (InternedType){.type=type, .llvm_type=NULL};
+	++compilation_unit->type_count;
+
+	return compilation_unit->type_count - 1;
+}
+
+static void addBuiltinTypes(CompilationUnit* compilation_unit) {
+	for (size_t i = 0; i < sizeof(BUILTIN_TYPES) / sizeof(BUILTIN_TYPES[0]); ++i) {
+		compilationUnit_getOrAddTypeIndex(compilation_unit, BUILTIN_TYPES[i]);
 	}
+}
 
-	//get new element and increment count
-	StructType* new_struct = compilation_unit->structs + compilation_unit->struct_count;
-	memset(new_struct, 0, sizeof(*new_struct));
-	++compilation_unit->struct_count;
+static StructType* addStructTypeTo(CompilationUnit* compilation_unit, SegmentedList* structs) {
+	//get new element, nothing already in the list moves
+	StructType* new_struct = segmentedList_add(structs, &compilation_unit->declaration_arena, sizeof(StructType), _Alignof(StructType));
 
 	//initialise members
 	new_struct->identifier_index = NULL_INDEX;
@@ -171,25 +375,9 @@ StructType* compilationUnit_addStructType(CompilationUnit* compilation_unit) {
 	return new_struct;
 }
 
-Variable* compilationUnit_addVariable(CompilationUnit* compilation_unit) {
-	//if at capacity then double capacity
-	if (compilation_unit->global_variable_count >= compilation_unit->global_variable_capacity) {
-		//attempt to double size
-		size_t new_size = compilation_unit->global_variable_capacity * sizeof(compilation_unit->global_variables[0]) * 2;
-		Variable* new_list = realloc(compilation_unit->global_variables, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		compilation_unit->global_variables = new_list;
-		compilation_unit->global_variable_capacity *= 2;
-	}
-
-	//get new element and increment count
-	Variable* new_variable = compilation_unit->global_variables + compilation_unit->global_variable_count;
-	memset(new_variable, 0, sizeof(*new_variable));
-	++compilation_unit->global_variable_count;
+static Variable* addGlobalVariableTo(CompilationUnit* compilation_unit, SegmentedList* global_variables) {
+	//get new element, nothing already in the list moves
+	Variable* new_variable = segmentedList_add(global_variables, &compilation_unit->declaration_arena, sizeof(Variable), _Alignof(Variable));
 
 	//initialise members
 	new_variable->identifier_index = NULL_INDEX;
@@ -197,43 +385,9 @@ Variable* compilationUnit_addVariable(CompilationUnit* compilation_unit) {
 	return new_variable;
 }
 
-Function* compilationUnit_addFunction(CompilationUnit* compilation_unit) {
-	//if at capacity then double capacity
-	if (compilation_unit->function_count >= compilation_unit->function_capacity) {
-		//attempt to double size
-		size_t new_size = compilation_unit->function_capacity * sizeof(compilation_unit->functions[0]) * 2;
-		Function* new_list = realloc(compilation_unit->functions, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		compilation_unit->functions = new_list;
-		compilation_unit->function_capacity *= 2;
-	}
-
-	//get new element and increment count
-	Function* new_function = compilation_unit->functions + compilation_unit->function_count;
-	memset(new_function, 0, sizeof(*new_function));
-	++compilation_unit->function_count;
-
-	//allocate initial memory for scope array
-	new_function->scope_capacity = INITIAL_LIST_CAPACITY;
-	size_t scopes_size = sizeof(new_function->scopes[0]) * INITIAL_LIST_CAPACITY;
-	new_function->scopes = malloc(scopes_size);
-	if (new_function->scopes == NULL) {
-		printf("ERROR: Failed to allocate memory for function scopes!\n");
-	}
-	memset(new_function->scopes, 0, scopes_size);
-
-	//allocate initial memory for parameter array
-	new_function->parameter_capacity = INITIAL_LIST_CAPACITY;
-	size_t parameters_size = sizeof(new_function->parameters[0]) * INITIAL_LIST_CAPACITY;
-	new_function->parameters = malloc(parameters_size);
-	if (new_function->parameters == NULL) {
-		printf("ERROR: Failed to allocate memory for function parameters!\n");
-	}
-	memset(new_function->parameters, 0, parameters_size);
+static Function* addFunctionTo(CompilationUnit* compilation_unit, SegmentedList* functions) {
+	//get new element, nothing already in the list moves
+	Function* new_function = segmentedList_add(functions, &compilation_unit->declaration_arena, sizeof(Function), _Alignof(Function));
 
 	//initialise members
 	new_function->identifier_index = NULL_INDEX;
@@ -241,25 +395,49 @@ Function* compilationUnit_addFunction(CompilationUnit* compilation_unit) {
 	return new_function;
 }
 
-Variable* compilationUnit_addFunctionParameter(Function* function) {
-	//if at capacity then double capacity
-	if (function->parameter_count >= function->parameter_capacity) {
-		//attempt to double size
-		size_t new_size = function->parameter_capacity * sizeof(function->parameters[0]) * 2;
-		Variable* new_list = realloc(function->parameters, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		function->parameters = new_list;
-		function->parameter_capacity *= 2;
+StructType* compilationUnit_addStructType(CompilationUnit* compilation_unit) {
+	return addStructTypeTo(compilation_unit, &compilation_unit->structs);
+}
+
+Variable* compilationUnit_addGlobalVariable(CompilationUnit* compilation_unit) {
+	return addGlobalVariableTo(compilation_unit, &compilation_unit->global_variables);
+}
+
+Function* compilationUnit_addFunction(CompilationUnit* compilation_unit) {
+	return addFunctionTo(compilation_unit, &compilation_unit->functions);
+}
+
+StructType* compilationUnit_addImportedStructType(CompilationUnit* compilation_unit) {
+	return addStructTypeTo(compilation_unit, &compilation_unit->imported_structs);
+}
+
+Variable* compilationUnit_addImportedGlobalVariable(CompilationUnit* compilation_unit) {
+	return addGlobalVariableTo(compilation_unit, &compilation_unit->imported_global_variables);
+}
+
+Function* compilationUnit_addImportedFunction(CompilationUnit* compilation_unit) {
+	return addFunctionTo(compilation_unit, &compilation_unit->imported_functions);
+}
+
+void compilationUnit_addImport(CompilationUnit* compilation_unit, InterfaceFile* interface_file) {
+	compilation_unit->imports = growList(&compilation_unit->declaration_arena, compilation_unit->imports, compilation_unit->import_count, &compilation_unit->import_capacity, sizeof(InterfaceFile*), _Alignof(InterfaceFile*));
+	compilation_unit->imports[compilation_unit->import_count] = interface_file;
+	++compilation_unit->import_count;
+}
+
+//the list itself is in declaration_arena and goes with it
+static void closeImports(CompilationUnit* compilation_unit) {
+	for (size_t i = 0; i < compilation_unit->import_count; ++i) {
+		interfaceFile_close(compilation_unit->imports[i]);
 	}
+	compilation_unit->imports = NULL;
+	compilation_unit->import_count = 0;
+	compilation_unit->import_capacity = 0;
+}
 
-	//get new element and increment count
-	Variable* new_parameter = function->parameters + function->parameter_count;
-	memset(new_parameter, 0, sizeof(*new_parameter));
-	++function->parameter_count;
+Variable* compilationUnit_addFunctionParameter(CompilationUnit* compilation_unit, Function* function) {
+	//get new element, nothing already in the list moves
+	Variable* new_parameter = segmentedList_add(&function->parameters, &compilation_unit->declaration_arena, sizeof(Variable), _Alignof(Variable));
 
 	//initialise members
 	new_parameter->identifier_index = NULL_INDEX;
@@ -268,60 +446,19 @@ Variable* compilationUnit_addFunctionParameter(Function* function) {
 }
 
 Scope* compilationUnit_addFunctionScope(CompilationUnit* compilation_unit, Function* function) {
-	//if at capacity then double capacity
-	if (function->scope_count >= function->scope_capacity) {
-		//attempt to double size
-		size_t new_size = function->scope_capacity * sizeof(function->scopes[0]) * 2;
-		Scope* new_list = realloc(function->scopes, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		function->scopes = new_list;
-		function->scope_capacity *= 2;
-	}
-
-	//get new element and increment count
-	Scope* new_scope = function->scopes + function->scope_count;
-	memset(new_scope, 0, sizeof(*new_scope));
-	++function->scope_count;
-
-	//allocate initial memory for variable array
-	new_scope->variable_capacity = INITIAL_LIST_CAPACITY;
-	size_t variables_size = sizeof(new_scope->variables[0]) * INITIAL_LIST_CAPACITY;
-	new_scope->variables = malloc(variables_size);
-	if (new_scope->variables == NULL) {
-		printf("ERROR: Failed to allocate memory for scope variables!\n");
-	}
-	memset(new_scope->variables, 0, variables_size);
+	//get new element, nothing already in the list moves
+	Scope* new_scope = segmentedList_add(&function->scopes, &compilation_unit->declaration_arena, sizeof(Scope), _Alignof(Scope));
 
 	//initialise members
 	new_scope->parent_scope_index = NULL_INDEX;
-	new_scope->parent_function_index = function - compilation_unit->functions;
+	new_scope->parent_function = function;
 
 	return new_scope;
 }
 
-Variable* compilationUnit_addScopeVariable(Scope* scope) {
-	//if at capacity then double capacity
-	if (scope->variable_count >= scope->variable_capacity) {
-		//attempt to double size
-		size_t new_size = scope->variable_capacity * sizeof(scope->variables[0]) * 2;
-		Variable* new_list = realloc(scope->variables, new_size);
-		if (new_list == NULL) {
-			printf("ERROR: Failed to double capacity of identifiers list!\n");
-			exit(1);
-		}
-		//set list and capacity if successful
-		scope->variables = new_list;
-		scope->variable_capacity *= 2;
-	}
-
-	//get new element and increment count
-	Variable* new_variable = scope->variables + scope->variable_count;
-	memset(new_variable, 0, sizeof(*new_variable));
-	++scope->variable_count;
+Variable* compilationUnit_addScopeVariable(CompilationUnit* compilation_unit, Scope* scope) {
+	//get new element, nothing already in the list moves
+	Variable* new_variable = segmentedList_add(&scope->variables, &compilation_unit->declaration_arena, sizeof(Variable), _Alignof(Variable));
 
 	//initialise members
 	new_variable->identifier_index = NULL_INDEX;
@@ -329,44 +466,167 @@ Variable* compilationUnit_addScopeVariable(Scope* scope) {
 	return new_variable;
 }
 
+void compilationUnit_reserveFunctionParameters(CompilationUnit* compilation_unit, Function* function, size_t count) {
+	segmentedList_reserve(&function->parameters, &compilation_unit->declaration_arena, function->parameters.count + count, sizeof(Variable), _Alignof(Variable));
+}
+
+void compilationUnit_reserveFunctionScopes(CompilationUnit* compilation_unit, Function* function, size_t count) {
+	segmentedList_reserve(&function->scopes, &compilation_unit->declaration_arena, function->scopes.count + count, sizeof(Scope), _Alignof(Scope));
+}
+
+void compilationUnit_reserveScopeVariables(CompilationUnit* compilation_unit, Scope* scope, size_t count) {
+	segmentedList_reserve(&scope->variables, &compilation_unit->declaration_arena, scope->variables.count + count, sizeof(Variable), _Alignof(Variable));
+}
+
 /*
 
-member list lookup
+top level symbols
 
 */
 
-Variable* compilationUnit_findVariableFromScope(CompilationUnit* compilation_unit, Function* parent_function, size_t scope_index, size_t variable_identifier_index) {
-	if (scope_index == NULL_INDEX) return NULL;
+static TopLevelSymbol* topLevelSymbol(CompilationUnit* compilation_unit, size_t identifier_index) {
+	//new entries start undeclared
+	size_t old_capacity = compilation_unit->top_level_symbol_capacity;
+	compilation_unit->top_level_symbols = reserveList(&compilation_unit->declaration_arena, compilation_unit->top_level_symbols, identifier_index + 1, &compilation_unit->top_level_symbol_capacity, sizeof(TopLevelSymbol), _Alignof(TopLevelSymbol));
+	memset(compilation_unit->top_level_symbols + old_capacity, 0, (compilation_unit->top_level_symbol_capacity - old_capacity) * sizeof(TopLevelSymbol));
 
-	//get helpful pointer
-	Scope* scope = parent_function->scopes + scope_index;
+	return compilation_unit->top_level_symbols + identifier_index;
+}
 
-	//check for variable in this scope
-	for (size_t i = 0; i < scope->variable_count; ++i) {
-		if (variable_identifier_index == scope->variables[i].identifier_index) {
-			return scope->variables + i;
-		}
+void compilationUnit_nameStructType(CompilationUnit* compilation_unit, StructType* struct_type, size_t identifier_index) {
+	struct_type->identifier_index = identifier_index;
+	topLevelSymbol(compilation_unit, identifier_index)->struct_type = struct_type;
+}
+
+void compilationUnit_nameGlobalVariable(CompilationUnit* compilation_unit, Variable* global_variable, size_t identifier_index) {
+	global_variable->identifier_index = identifier_index;
+	topLevelSymbol(compilation_unit, identifier_index)->global_variable = global_variable;
+}
+
+void compilationUnit_nameFunction(CompilationUnit* compilation_unit, Function* function, size_t identifier_index) {
+	function->identifier_index = identifier_index;
+	topLevelSymbol(compilation_unit, identifier_index)->function = function;
+}
+
+StructType* compilationUnit_findStructType(CompilationUnit* compilation_unit, size_t identifier_index) {
+	if (identifier_index < compilation_unit->top_level_symbol_capacity && compilation_unit->top_level_symbols[identifier_index].struct_type != NULL) {
+		return compilation_unit->top_level_symbols[identifier_index].struct_type;
 	}
 
-	//if no parent scope check function parameters and globals
-	if (scope->parent_scope_index == NULL_INDEX) {
-		//parameters
-		for (size_t i = 0; i < parent_function->parameter_count; ++i) {
-			if (variable_identifier_index == parent_function->parameters[i].identifier_index) {
-				return parent_function->parameters + i;
-			}
-		}
-		//globals
-		for (size_t i = 0; i < compilation_unit->global_variable_count; ++i) {
-			if (variable_identifier_index == compilation_unit->global_variables[i].identifier_index) {
-				return compilation_unit->global_variables + i;
-			}
-		}
+	//loading names the declaration, so it is found above from then on
+	for (size_t i = 0; i < compilation_unit->import_count; ++i) {
+		StructType* struct_type = interfaceFile_loadStructType(compilation_unit->imports[i], compilation_unit, identifier_index);
+		if (struct_type != NULL) return struct_type;
+	}
+	return NULL;
+}
+
+Variable* compilationUnit_findGlobalVariable(CompilationUnit* compilation_unit, size_t identifier_index) {
+	if (identifier_index < compilation_unit->top_level_symbol_capacity && compilation_unit->top_level_symbols[identifier_index].global_variable != NULL) {
+		return compilation_unit->top_level_symbols[identifier_index].global_variable;
+	}
+
+	for (size_t i = 0; i < compilation_unit->import_count; ++i) {
+		Variable* global_variable = interfaceFile_loadGlobalVariable(compilation_unit->imports[i], compilation_unit, identifier_index);
+		if (global_variable != NULL) return global_variable;
+	}
+	return NULL;
+}
+
+Function* compilationUnit_findFunction(CompilationUnit* compilation_unit, size_t identifier_index) {
+	if (identifier_index < compilation_unit->top_level_symbol_capacity && compilation_unit->top_level_symbols[identifier_index].function != NULL) {
+		return compilation_unit->top_level_symbols[identifier_index].function;
+	}
+
+	for (size_t i = 0; i < compilation_unit->import_count; ++i) {
+		Function* function = interfaceFile_loadFunction(compilation_unit->imports[i], compilation_unit, identifier_index);
+		if (function != NULL) return function;
+	}
+	return NULL;
+}
+
+/*
+
+symbol table
 
-		//if not found by now, variable does not exist
-		return NULL;
+*/
+
+static void bindSymbol(CompilationUnit* compilation_unit, size_t identifier_index, Symbol symbol) {
+	SymbolTable* symbol_table = &compilation_unit->symbol_table;
+	Symbol* bound_symbol = symbol_table->symbols + identifier_index;
+
+	//the first of two variables with the same name in one scope wins
+	if (bound_symbol->scope_index == symbol.scope_index) return;
+
+	//globals are bound below every scope so are never undone
+	if (symbol.scope_index != SYMBOL_GLOBAL) {
+		symbol_table->undo_log = growList(&compilation_unit->declaration_arena, symbol_table->undo_log, symbol_table->undo_count, &symbol_table->undo_capacity, sizeof(SymbolUndo), _Alignof(SymbolUndo));
+		symbol_table->undo_log[symbol_table->undo_count] = (SymbolUndo){.identifier_index=identifier_index, .previous=*bound_symbol};
+		++symbol_table->undo_count;
+	}
+	*bound_symbol = symbol;
+}
+
+void compilationUnit_enterFunction(CompilationUnit* compilation_unit, Function* function) {
+	SymbolTable* symbol_table = &compilation_unit->symbol_table;
+
+	//identifiers can be added after an earlier function body, new ones start unbound
+	size_t old_capacity = symbol_table->symbol_capacity;
+	symbol_table->symbols = reserveList(&compilation_unit->declaration_arena, symbol_table->symbols, compilation_unit->identifier_count, &symbol_table->symbol_capacity, sizeof(Symbol), _Alignof(Symbol));
+	for (size_t i = old_capacity; i < symbol_table->symbol_capacity; ++i) {
+		symbol_table->symbols[i] = (Symbol){.scope_index=NULL_INDEX, .variable_index=NULL_INDEX};
+	}
+
+	//only globals added since the last function body need binding
+	for (; symbol_table->bound_global_count < compilation_unit->global_variables.count; ++symbol_table->bound_global_count) {
+		size_t global_index = symbol_table->bound_global_count;
+		Symbol symbol = {.scope_index=SYMBOL_GLOBAL, .variable_index=global_index};
+		bindSymbol(compilation_unit, compilationUnit_getGlobalVariable(compilation_unit, global_index)->identifier_index, symbol);
 	}
 
-	//check for variable in parent scope
-	return compilationUnit_findVariableFromScope(compilation_unit, parent_function, scope->parent_scope_index, variable_identifier_index);
+	//parameters shadow globals
+	compilationUnit_enterScope(compilation_unit);
+	for (size_t i = 0; i < function->parameters.count; ++i) {
+		Symbol symbol = {.scope_index=SYMBOL_PARAMETER, .variable_index=i};
+		bindSymbol(compilation_unit, compilationUnit_getFunctionParameter(function, i)->identifier_index, symbol);
+	}
+}
+
+void compilationUnit_enterScope(CompilationUnit* compilation_unit) {
+	SymbolTable* symbol_table = &compilation_unit->symbol_table;
+	symbol_table->scope_starts = growList(&compilation_unit->declaration_arena, symbol_table->scope_starts, symbol_table->scope_depth, &symbol_table->scope_capacity, sizeof(size_t), _Alignof(size_t));
+	symbol_table->scope_starts[symbol_table->scope_depth] = symbol_table->undo_count;
+	++symbol_table->scope_depth;
+}
+
+void compilationUnit_exitScope(CompilationUnit* compilation_unit) {
+	SymbolTable* symbol_table = &compilation_unit->symbol_table;
+	--symbol_table->scope_depth;
+	size_t scope_start = symbol_table->scope_starts[symbol_table->scope_depth];
+
+	//undo in reverse so a name bound twice ends up as it was before both
+	while (symbol_table->undo_count > scope_start) {
+		--symbol_table->undo_count;
+		SymbolUndo* undo = symbol_table->undo_log + symbol_table->undo_count;
+		symbol_table->symbols[undo->identifier_index] = undo->previous;
+	}
+}
+
+void compilationUnit_bindScopeVariable(CompilationUnit* compilation_unit, Function* function, size_t scope_index, size_t variable_index) {
+	Symbol symbol = {.scope_index=scope_index, .variable_index=variable_index};
+	Scope* scope = compilationUnit_getFunctionScope(function, scope_index);
+	bindSymbol(compilation_unit, compilationUnit_getScopeVariable(scope, variable_index)->identifier_index, symbol);
+}
+
+Variable* compilationUnit_findVariable(CompilationUnit* compilation_unit, Function* function, size_t variable_identifier_index) {
+	SymbolTable* symbol_table = &compilation_unit->symbol_table;
+	if (variable_identifier_index >= symbol_table->symbol_capacity) return NULL;
+
+	Symbol symbol = symbol_table->symbols[variable_identifier_index];
+	switch (symbol.scope_index) {
+		case NULL_INDEX: return NULL;
+		case SYMBOL_PARAMETER: return compilationUnit_getFunctionParameter(function, symbol.variable_index);
+		case SYMBOL_GLOBAL: return compilationUnit_getGlobalVariable(compilation_unit, symbol.variable_index);
+		default: return compilationUnit_getScopeVariable(compilationUnit_getFunctionScope(function, symbol.scope_index), symbol.variable_index);
+	}
 }
@@ -4,11 +4,21 @@
 #include <llvm-c/Types.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "arena.h"
+#include "interner.h"
+#include "segmented_list.h"
+#include "token.h"
+
 //used as an equivalent of null for indexes
 #define NULL_INDEX ((size_t)-1)
 
+//number of zero bytes guaranteed to follow the source buffer
+//lets the tokeniser use '\0' as a sentinel instead of bounds checking every character
+#define SOURCE_PADDING 64
+
 /*
 
 Variable and struct type structs/enum
@@ -30,6 +40,7 @@ typedef enum {
 //forward declarations
 typedef struct StructType StructType;
 typedef struct Function Function;
+typedef struct InterfaceFile InterfaceFile;
 
 typedef struct {
 	TypeKind kind;
@@ -39,14 +50,31 @@ typedef struct {
 	} data;
 } VariableType;
 
+//each distinct VariableType is interned once per compilation unit, so types are passed around and compared as indexes
 typedef struct {
-	size_t identifier_index; //in compilation unit member "identifiers"
 	VariableType type;
+	LLVMTypeRef llvm_type; //built the first time it is needed, NULL until then
+} InternedType;
+
+//types every compilation unit starts with, in compilation unit member "types"
+#define TYPE_INDEX_NONE 0
+#define TYPE_INDEX_VOID 1
+#define TYPE_INDEX_BOOL 2
+#define TYPE_INDEX_CHAR 3
+#define TYPE_INDEX_INT 4 //64 bit, integer literals default to it
+#define TYPE_INDEX_FLOAT 5 //64 bit, real literals default to it
+#define TYPE_INDEX_STRING 6 //struct without a struct type, used by string literals
+#define TYPE_INDEX_BOOL_LITERAL 7 //1 bit char, used by true and false
+
+typedef struct {
+	size_t identifier_index; //in compilation unit member "identifiers"
+	size_t type_index; //in compilation unit member "types"
 } StructMember;
 
 struct StructType {
 	size_t identifier_index; //in compilation unit member "identifiers"
 	StructMember* members;
+	size_t member_count;
 };
 
 /*
@@ -57,32 +85,25 @@ Variable and function structs
 
 typedef struct {
 	size_t identifier_index; //in compilation unit member "identifiers"
-	VariableType type;
+	size_t type_index; //in compilation unit member "types"
 
 	//llvm data
 	LLVMValueRef llvm_stack_pointer;
-	LLVMTypeRef llvm_type;
 } Variable;
 
 typedef struct Scope Scope;
 struct Scope {
-	size_t parent_function_index; //in compilation unit member "functions", will be initialised by creation function
+	Function* parent_function; //will be initialised by creation function
 	size_t parent_scope_index; //in parent function member "scopes"
-	Variable* variables;
-	size_t variable_count;
-	size_t variable_capacity;
+	SegmentedList variables; //of Variable
 };
 
 struct Function {
 	size_t identifier_index; //in compilation unit member "identifiers"
-	Variable* parameters;
-	size_t parameter_count;
-	size_t parameter_capacity;
-	VariableType return_type;
+	SegmentedList parameters; //of Variable
+	size_t return_type_index; //in compilation unit member "types"
 
-	Scope* scopes;
-	size_t scope_count;
-	size_t scope_capacity;
+	SegmentedList scopes; //of Scope
 
 	//llvm data
 	LLVMTypeRef llvm_function_type;
@@ -92,35 +113,118 @@ struct Function {
 
 /*
 
+Symbol table
+
+*/
+
+//what an identifier names while a function body is parsed
+typedef struct {
+	size_t scope_index; //in the function member "scopes", or SYMBOL_PARAMETER, SYMBOL_GLOBAL or NULL_INDEX if unbound
+	size_t variable_index; //in the variables of that scope, the function parameters or the global variables
+} Symbol;
+
+#define SYMBOL_PARAMETER (NULL_INDEX - 1)
+#define SYMBOL_GLOBAL (NULL_INDEX - 2)
+
+typedef struct {
+	size_t identifier_index;
+	Symbol previous; //restored when the scope that bound identifier_index is left
+} SymbolUndo;
+
+//identifier index to the variable it names in the open scopes, inner scopes shadow outer ones
+//each binding logs what it hid so leaving a scope undoes only its own, lookups never walk the scopes
+typedef struct {
+	Symbol* symbols; //indexed by identifier index
+	size_t symbol_capacity;
+	size_t bound_global_count; //globals stay bound below every scope once bound
+
+	SymbolUndo* undo_log;
+	size_t undo_count;
+	size_t undo_capacity;
+
+	size_t* scope_starts; //undo_count when each open scope was entered
+	size_t scope_depth;
+	size_t scope_capacity;
+} SymbolTable;
+
+//what a top level identifier is declared as, each is NULL if it is not declared as that
+typedef struct {
+	Function* function;
+	StructType* struct_type;
+	Variable* global_variable;
+} TopLevelSymbol;
+
+/*
+
 Compilation unit
 
 */
 
+//one slot of the open addressing table over the identifiers list
+//the hash and length are kept so most mismatches are found without touching the identifier text
+typedef struct {
+	uint32_t hash;
+	uint32_t length;
+	uint32_t identifier_index; //in compilation unit member "identifiers", UINT32_MAX for an empty slot
+} IdentifierSlot;
+
 //memory allocated for compilation unit members must live until the entire compilation unit is destroyed
 typedef struct {
-	char* source_path;
-	FILE* source_file;
+	char* source_path; //"-" for standard input
+	//whole source file followed by SOURCE_PADDING zero bytes
+	//NULL when the source is not a regular file, it is then streamed from source_descriptor by tokenise()
+	char* source;
+	size_t source_length;
+	int source_descriptor; //-1 once the source is loaded
+
+	//lexed once by tokenise() and shared by every parse pass
+	TokenList token_list;
 
 	LLVMContextRef llvm_context;
 	LLVMModuleRef llvm_module;
+
+	//own every list below and everything they point to, so destroying the compilation unit frees them all at once
+	//declarations are kept apart from identifiers so they can be cleared on their own
+	Arena identifier_arena;
+	Arena declaration_arena;
 	
 	//it is important that all identifier pointers refer to data in this member
 	//this allows for fast identifier checking via pointer comparison
 	char** identifiers;
 	size_t identifier_count;
 	size_t identifier_capacity;
-
-	StructType* structs;
-	size_t struct_count;
-	size_t struct_capacity;
-
-	Variable* global_variables;
-	size_t global_variable_count;
-	size_t global_variable_capacity;
-
-	Function* functions;
-	size_t function_count;
-	size_t function_capacity;
+	//finds the index of an identifier, capacity is a power of two kept at least twice identifier_count
+	IdentifierSlot* identifier_table;
+	size_t identifier_table_capacity;
+	//NULL unless set by compilationUnit_setInterner, identifier_table is then unused
+	//identifiers then holds the interner's strings at the indices this unit has used and NULL at the rest
+	Interner* interner;
+
+	//in declaration_arena since struct types refer to structs
+	InternedType* types;
+	size_t type_count;
+	size_t type_capacity;
+
+	//declarations never move once added so pointers to them can be held while more are parsed
+	SegmentedList structs; //of StructType
+	SegmentedList global_variables; //of Variable
+	SegmentedList functions; //of Function
+	//declarations loaded from imports, kept apart so only the unit's own are compiled and written to its interface file
+	SegmentedList imported_structs; //of StructType
+	SegmentedList imported_global_variables; //of Variable
+	SegmentedList imported_functions; //of Function
+
+	//interface files of every import, owned and closed along with the declarations, in declaration_arena
+	InterfaceFile** imports;
+	size_t import_count;
+	size_t import_capacity;
+
+	//indexed by identifier index, filled in as the top level is parsed, in declaration_arena
+	TopLevelSymbol* top_level_symbols;
+	size_t top_level_symbol_capacity;
+
+	//only holds anything while a function body is being parsed, in declaration_arena
+	SymbolTable symbol_table;
 } CompilationUnit;
 
 /*
@@ -131,17 +235,78 @@ Functions
 
 //creation/destruction
 CompilationUnit compilationUnit_create(const char* source_path, LLVMContextRef llvm_context);
+//source is a copy of text instead of a file, source_name stands in for the path
+CompilationUnit compilationUnit_createFromText(const char* source_name, const char* text, size_t text_length, LLVMContextRef llvm_context);
 void compilationUnit_destroy(CompilationUnit* compilation_unit);
+//forgets every struct, global variable and function along with the llvm module so the top level can be parsed again
+//identifiers and the source are kept
+void compilationUnit_clearDeclarations(CompilationUnit* compilation_unit);
+//identifiers are interned in interner from then on so their indices can be compared with other units sharing it
+//must be called before any identifier is added, interner is not owned and must outlive the compilation unit
+void compilationUnit_setInterner(CompilationUnit* compilation_unit, Interner* interner);
 
 //member list modification
-size_t compilationUnit_getOrAddIdentifierIndex(CompilationUnit* compilation_unit, const char* identifier);
+//identifier does not need to be null terminated
+size_t compilationUnit_getOrAddIdentifierIndex(CompilationUnit* compilation_unit, const char* identifier, size_t identifier_length);
+//types are few so this is a search of every type so far
+size_t compilationUnit_getOrAddTypeIndex(CompilationUnit* compilation_unit, VariableType type);
 StructType* compilationUnit_addStructType(CompilationUnit* compilation_unit);
 Variable* compilationUnit_addGlobalVariable(CompilationUnit* compilation_unit);
 
 Function* compilationUnit_addFunction(CompilationUnit* compilation_unit);
-Variable* compilationUnit_addFunctionParameter(Function* function);
+StructType* compilationUnit_addImportedStructType(CompilationUnit* compilation_unit);
+Variable* compilationUnit_addImportedGlobalVariable(CompilationUnit* compilation_unit);
+Function* compilationUnit_addImportedFunction(CompilationUnit* compilation_unit);
+//takes ownership of interface_file, it is closed when the declarations are cleared
+void compilationUnit_addImport(CompilationUnit* compilation_unit, InterfaceFile* interface_file);
+Variable* compilationUnit_addFunctionParameter(CompilationUnit* compilation_unit, Function* function);
 Scope* compilationUnit_addFunctionScope(CompilationUnit* compilation_unit, Function* function);
-Variable* compilationUnit_addScopeVariable(Scope* scope);
-
-//member list lookup
-Variable* compilationUnit_findVariableFromScope(CompilationUnit* compilation_unit, Function* parent_function, size_t scope_index, size_t variable_identifier_index);
+Variable* compilationUnit_addScopeVariable(CompilationUnit* compilation_unit, Scope* scope);
+//room for count more elements up front, so a list sized before it is filled is one allocation
+void compilationUnit_reserveFunctionParameters(CompilationUnit* compilation_unit, Function* function, size_t count);
+void compilationUnit_reserveFunctionScopes(CompilationUnit* compilation_unit, Function* function, size_t count);
+void compilationUnit_reserveScopeVariables(CompilationUnit* compilation_unit, Scope* scope, size_t count);
+
+//member list access, index must be less than the count of the list
+static inline StructType* compilationUnit_getStructType(const CompilationUnit* compilation_unit, size_t index) {
+	return segmentedList_get(&compilation_unit->structs, index, sizeof(StructType));
+}
+static inline Variable* compilationUnit_getGlobalVariable(const CompilationUnit* compilation_unit, size_t index) {
+	return segmentedList_get(&compilation_unit->global_variables, index, sizeof(Variable));
+}
+static inline Function* compilationUnit_getFunction(const CompilationUnit* compilation_unit, size_t index) {
+	return segmentedList_get(&compilation_unit->functions, index, sizeof(Function));
+}
+static inline Variable* compilationUnit_getFunctionParameter(const Function* function, size_t index) {
+	return segmentedList_get(&function->parameters, index, sizeof(Variable));
+}
+static inline Scope* compilationUnit_getFunctionScope(const Function* function, size_t index) {
+	return segmentedList_get(&function->scopes, index, sizeof(Scope));
+}
+static inline Variable* compilationUnit_getScopeVariable(const Scope* scope, size_t index) {
+	return segmentedList_get(&scope->variables, index, sizeof(Variable));
+}
+
+//set the identifier of a top level declaration and record it in top_level_symbols
+//a later declaration with the same name replaces an earlier one
+void compilationUnit_nameStructType(CompilationUnit* compilation_unit, StructType* struct_type, size_t identifier_index);
+void compilationUnit_nameGlobalVariable(CompilationUnit* compilation_unit, Variable* global_variable, size_t identifier_index);
+void compilationUnit_nameFunction(CompilationUnit* compilation_unit, Function* function, size_t identifier_index);
+
+//top level lookup, NULL if nothing of that kind has the name
+//names the unit does not declare itself are looked up in its imports in order, and loaded from the first that has one
+StructType* compilationUnit_findStructType(CompilationUnit* compilation_unit, size_t identifier_index);
+Variable* compilationUnit_findGlobalVariable(CompilationUnit* compilation_unit, size_t identifier_index);
+Function* compilationUnit_findFunction(CompilationUnit* compilation_unit, size_t identifier_index);
+
+//symbol table
+//binds the globals and the parameters of function in a scope of their own, left with compilationUnit_exitScope
+void compilationUnit_enterFunction(CompilationUnit* compilation_unit, Function* function);
+void compilationUnit_enterScope(CompilationUnit* compilation_unit);
+//unbinds everything bound since the matching enter
+void compilationUnit_exitScope(CompilationUnit* compilation_unit);
+//variable_index is in the variables of scope scope_index of the function being parsed, which must be the innermost open scope
+//a name already bound by the same scope keeps its first variable
+void compilationUnit_bindScopeVariable(CompilationUnit* compilation_unit, Function* function, size_t scope_index, size_t variable_index);
+//NULL if nothing in the open scopes has that name
+Variable* compilationUnit_findVariable(CompilationUnit* compilation_unit, Function* function, size_t variable_identifier_index);
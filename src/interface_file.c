@@ -0,0 +1,516 @@
+#include "interface_file.h"
+
+#include <fcntl.h>
+#include <llvm-c/Core.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "compilation_unit.h"
+#include "parser_utils.h"
+
+//"IFC1" when read back on a machine of the same byte order
+#define INTERFACE_FILE_MAGIC 0x31434649u
+#define INTERFACE_FILE_VERSION 1
+
+//a file is a header then each section in the order of its counts, names are offsets into the string data at the end
+//every record is made of uint32_t so each section starts aligned
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t table_capacity; //power of two, at least twice the named declarations
+	uint32_t struct_count;
+	uint32_t member_count;
+	uint32_t global_count;
+	uint32_t function_count;
+	uint32_t parameter_count;
+	uint32_t string_data_length;
+} InterfaceHeader;
+
+typedef enum {
+	DECLARATION_STRUCT,
+	DECLARATION_GLOBAL_VARIABLE,
+	DECLARATION_FUNCTION,
+} DeclarationKind;
+
+//open addressing table over the names of the declarations, probed like the identifier tables
+typedef struct {
+	uint32_t hash;
+	uint32_t kind; //DeclarationKind
+	uint32_t record; //in the section of kind, UINT32_MAX for an empty slot
+} InterfaceSlot;
+
+typedef struct {
+	uint32_t name_offset;
+	uint32_t name_length;
+} InterfaceName;
+
+typedef struct {
+	uint32_t kind; //TypeKind
+	uint32_t data; //width, or for TYPE_STRUCT the struct record and UINT32_MAX for a struct without a struct type
+} InterfaceType;
+
+//members, globals and parameters
+typedef struct {
+	InterfaceName name;
+	InterfaceType type;
+} InterfaceVariable;
+
+typedef struct {
+	InterfaceName name;
+	uint32_t first_member;
+	uint32_t member_count;
+} InterfaceStruct;
+
+typedef struct {
+	InterfaceName name;
+	InterfaceType return_type;
+	uint32_t first_parameter;
+	uint32_t parameter_count;
+} InterfaceFunction;
+
+struct InterfaceFile {
+	char* path;
+	void* map;
+	size_t map_size;
+
+	//sections of the map
+	const InterfaceHeader* header;
+	const InterfaceSlot* table;
+	const InterfaceStruct* structs;
+	const InterfaceVariable* members;
+	const InterfaceVariable* globals;
+	const InterfaceFunction* functions;
+	const InterfaceVariable* parameters;
+	const char* string_data;
+
+	//struct record to what it was loaded as, NULL until it is, so types referring to a struct share one StructType
+	StructType** loaded_structs;
+};
+
+//fnv-1a, as compilation units hash their identifiers
+static uint32_t hashName(const char* name, size_t name_length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < name_length; ++i) {
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+
+writing
+
+*/
+
+//one growing section of the file being written
+typedef struct {
+	char* data;
+	size_t length;
+	size_t capacity;
+} Section;
+
+static void sectionAppend(Section* section, const void* data, size_t size) {
+	if (section->length + size > section->capacity) {
+		section->capacity = (section->length + size) * 2;
+		section->data = realloc(section->data, section->capacity);
+		if (section->data == NULL) {
+			printf("ERROR: Failed to grow interface file section to %zu bytes!\n", section->capacity);
+			exit(1);
+		}
+	}
+	memcpy(section->data + section->length, data, size);
+	section->length += size;
+}
+
+typedef struct {
+	const CompilationUnit* compilation_unit;
+
+	//every struct written, the unit's own then any of its imports that a type refers to
+	const StructType** structs;
+	size_t struct_count;
+	size_t struct_capacity;
+
+	Section structs_section;
+	Section members_section;
+	Section globals_section;
+	Section functions_section;
+	Section parameters_section;
+	Section string_data;
+} InterfaceWriter;
+
+static uint32_t sectionRecordCount(const Section* section, size_t record_size) {
+	return section->length / record_size;
+}
+
+static InterfaceName writeName(InterfaceWriter* writer, size_t identifier_index) {
+	const char* identifier = writer->compilation_unit->identifiers[identifier_index];
+	InterfaceName name = {.name_offset=writer->string_data.length, .name_length=strlen(identifier)};
+	sectionAppend(&writer->string_data, identifier, name.name_length);
+	return name;
+}
+
+//record a struct will be written at, structs from imports are added the first time a type refers to them
+static uint32_t structRecord(InterfaceWriter* writer, const StructType* struct_type) {
+	for (size_t i = 0; i < writer->struct_count; ++i) {
+		if (writer->structs[i] == struct_type) return i;
+	}
+
+	if (writer->struct_count >= writer->struct_capacity) {
+		writer->struct_capacity = writer->struct_capacity == 0 ? 4 : writer->struct_capacity * 2;
+		writer->structs = realloc(writer->structs, writer->struct_capacity * sizeof(writer->structs[0]));
+		if (writer->structs == NULL) {
+			printf("ERROR: Failed to grow interface file struct list!\n");
+			exit(1);
+		}
+	}
+	writer->structs[writer->struct_count] = struct_type;
+	++writer->struct_count;
+	return writer->struct_count - 1;
+}
+
+static InterfaceType writeType(InterfaceWriter* writer, size_t type_index) {
+	VariableType type = writer->compilation_unit->types[type_index].type;
+	if (type.kind != TYPE_STRUCT) return (InterfaceType){.kind=type.kind, .data=type.data.width};
+	if (type.data.struct_type == NULL) return (InterfaceType){.kind=TYPE_STRUCT, .data=UINT32_MAX};
+	return (InterfaceType){.kind=TYPE_STRUCT, .data=structRecord(writer, type.data.struct_type)};
+}
+
+static void writeVariable(InterfaceWriter* writer, Section* section, const Variable* variable) {
+	InterfaceVariable record = {.name=writeName(writer, variable->identifier_index), .type=writeType(writer, variable->type_index)};
+	sectionAppend(section, &record, sizeof(record));
+}
+
+static void writeDeclarations(InterfaceWriter* writer) {
+	const CompilationUnit* compilation_unit = writer->compilation_unit;
+
+	//the unit's own structs come first so their records match their indices
+	for (size_t i = 0; i < compilation_unit->structs.count; ++i) {
+		structRecord(writer, compilationUnit_getStructType(compilation_unit, i));
+	}
+
+	for (size_t i = 0; i < compilation_unit->global_variables.count; ++i) {
+		writeVariable(writer, &writer->globals_section, compilationUnit_getGlobalVariable(compilation_unit, i));
+	}
+
+	for (size_t i = 0; i < compilation_unit->functions.count; ++i) {
+		const Function* function = compilationUnit_getFunction(compilation_unit, i);
+		InterfaceFunction record = {
+			.name=writeName(writer, function->identifier_index),
+			.return_type=writeType(writer, function->return_type_index),
+			.first_parameter=sectionRecordCount(&writer->parameters_section, sizeof(InterfaceVariable)),
+			.parameter_count=function->parameters.count,
+		};
+		sectionAppend(&writer->functions_section, &record, sizeof(record));
+		for (size_t j = 0; j < function->parameters.count; ++j) {
+			writeVariable(writer, &writer->parameters_section, compilationUnit_getFunctionParameter(function, j));
+		}
+	}
+
+	//members can refer to more structs, which are written when the loop reaches them
+	for (size_t i = 0; i < writer->struct_count; ++i) {
+		const StructType* struct_type = writer->structs[i];
+		InterfaceStruct record = {
+			.name=writeName(writer, struct_type->identifier_index),
+			.first_member=sectionRecordCount(&writer->members_section, sizeof(InterfaceVariable)),
+			.member_count=struct_type->member_count,
+		};
+		sectionAppend(&writer->structs_section, &record, sizeof(record));
+		for (size_t j = 0; j < struct_type->member_count; ++j) {
+			const StructMember* member = struct_type->members + j;
+			InterfaceVariable member_record = {.name=writeName(writer, member->identifier_index), .type=writeType(writer, member->type_index)};
+			sectionAppend(&writer->members_section, &member_record, sizeof(member_record));
+		}
+	}
+}
+
+static void addSlot(InterfaceSlot* table, uint32_t table_capacity, const InterfaceWriter* writer, InterfaceName name, DeclarationKind kind, uint32_t record) {
+	uint32_t hash = hashName(writer->string_data.data + name.name_offset, name.name_length);
+	uint32_t mask = table_capacity - 1;
+	uint32_t i = hash & mask;
+	while (table[i].record != UINT32_MAX) i = (i + 1) & mask;
+	table[i] = (InterfaceSlot){.hash=hash, .kind=kind, .record=record};
+}
+
+void interfaceFile_write(const CompilationUnit* compilation_unit, const char* path) {
+	InterfaceWriter writer;
+	memset(&writer, 0, sizeof(writer));
+	writer.compilation_unit = compilation_unit;
+	writeDeclarations(&writer);
+
+	InterfaceHeader header = {
+		.magic=INTERFACE_FILE_MAGIC,
+		.version=INTERFACE_FILE_VERSION,
+		.struct_count=writer.struct_count,
+		.member_count=sectionRecordCount(&writer.members_section, sizeof(InterfaceVariable)),
+		.global_count=sectionRecordCount(&writer.globals_section, sizeof(InterfaceVariable)),
+		.function_count=sectionRecordCount(&writer.functions_section, sizeof(InterfaceFunction)),
+		.parameter_count=sectionRecordCount(&writer.parameters_section, sizeof(InterfaceVariable)),
+		.string_data_length=writer.string_data.length,
+	};
+
+	//only the unit's own structs are found by name, ones from its imports are only there for types to refer to
+	size_t named_count = compilation_unit->structs.count + header.global_count + header.function_count;
+	header.table_capacity = 1;
+	while (header.table_capacity < named_count * 2) header.table_capacity *= 2;
+	size_t table_size = header.table_capacity * sizeof(InterfaceSlot);
+	InterfaceSlot* table = malloc(table_size);
+	if (table == NULL) {
+		printf("ERROR: Failed to allocate %zu bytes for interface file table!\n", table_size);
+		exit(1);
+	}
+	memset(table, 0xff, table_size);
+
+	const InterfaceStruct* struct_records = (const InterfaceStruct*)writer.structs_section.data;
+	const InterfaceVariable* global_records = (const InterfaceVariable*)writer.globals_section.data;
+	const InterfaceFunction* function_records = (const InterfaceFunction*)writer.functions_section.data;
+	for (uint32_t i = 0; i < compilation_unit->structs.count; ++i) {
+		addSlot(table, header.table_capacity, &writer, struct_records[i].name, DECLARATION_STRUCT, i);
+	}
+	for (uint32_t i = 0; i < header.global_count; ++i) {
+		addSlot(table, header.table_capacity, &writer, global_records[i].name, DECLARATION_GLOBAL_VARIABLE, i);
+	}
+	for (uint32_t i = 0; i < header.function_count; ++i) {
+		addSlot(table, header.table_capacity, &writer, function_records[i].name, DECLARATION_FUNCTION, i);
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("ERROR: Failed to open interface file %s for writing!\n", path);
+		exit(1);
+	}
+	bool failed = fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(table, 1, table_size, file) != table_size;
+	const Section* sections[] = {
+		&writer.structs_section, &writer.members_section, &writer.globals_section,
+		&writer.functions_section, &writer.parameters_section, &writer.string_data,
+	};
+	for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+		failed = failed || fwrite(sections[i]->data, 1, sections[i]->length, file) != sections[i]->length;
+	}
+	if (fclose(file) != 0 || failed) {
+		printf("ERROR: Failed to write interface file %s!\n", path);
+		exit(1);
+	}
+
+	free(table);
+	free(writer.structs);
+	for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+		free(sections[i]->data);
+	}
+}
+
+/*
+
+reading
+
+*/
+
+static void corruptFile(const InterfaceFile* interface_file) {
+	printf("ERROR: Interface file %s is corrupt or was written by another version!\n", interface_file->path);
+	exit(1);
+}
+
+//first and count are records of a section of limit records
+static void checkRange(const InterfaceFile* interface_file, uint64_t first, uint64_t count, uint64_t limit) {
+	if (first > limit || count > limit - first) corruptFile(interface_file);
+}
+
+InterfaceFile* interfaceFile_open(const char* path) {
+	InterfaceFile* interface_file = calloc(1, sizeof(InterfaceFile));
+	size_t path_size = strlen(path) + 1;
+	if (interface_file == NULL || (interface_file->path = malloc(path_size)) == NULL) {
+		printf("ERROR: Failed to allocate interface file %s!\n", path);
+		exit(1);
+	}
+	memcpy(interface_file->path, path, path_size);
+
+	int file_descriptor = open(path, O_RDONLY);
+	struct stat file_status;
+	if (file_descriptor < 0 || fstat(file_descriptor, &file_status) != 0) {
+		printf("ERROR: Failed to open interface file %s, the imported source must be compiled first!\n", path);
+		exit(1);
+	}
+	interface_file->map_size = file_status.st_size;
+	if (interface_file->map_size < sizeof(InterfaceHeader)) corruptFile(interface_file);
+	interface_file->map = mmap(NULL, interface_file->map_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if (interface_file->map == MAP_FAILED) {
+		printf("ERROR: Failed to map interface file %s!\n", path);
+		exit(1);
+	}
+
+	//only the header and section bounds are checked here, each record is checked when it is loaded
+	const InterfaceHeader* header = interface_file->map;
+	if (header->magic != INTERFACE_FILE_MAGIC || header->version != INTERFACE_FILE_VERSION) corruptFile(interface_file);
+	if (header->table_capacity == 0 || (header->table_capacity & (header->table_capacity - 1)) != 0) corruptFile(interface_file);
+	uint64_t file_size = sizeof(InterfaceHeader) +
+		(uint64_t)header->table_capacity * sizeof(InterfaceSlot) +
+		(uint64_t)header->struct_count * sizeof(InterfaceStruct) +
+		((uint64_t)header->member_count + header->global_count + header->parameter_count) * sizeof(InterfaceVariable) +
+		(uint64_t)header->function_count * sizeof(InterfaceFunction) +
+		header->string_data_length;
+	if (file_size != interface_file->map_size) corruptFile(interface_file);
+
+	interface_file->header = header;
+	interface_file->table = (const InterfaceSlot*)(header + 1);
+	interface_file->structs = (const InterfaceStruct*)(interface_file->table + header->table_capacity);
+	interface_file->members = (const InterfaceVariable*)(interface_file->structs + header->struct_count);
+	interface_file->globals = interface_file->members + header->member_count;
+	interface_file->functions = (const InterfaceFunction*)(interface_file->globals + header->global_count);
+	interface_file->parameters = (const InterfaceVariable*)(interface_file->functions + header->function_count);
+	interface_file->string_data = (const char*)(interface_file->parameters + header->parameter_count);
+
+	interface_file->loaded_structs = calloc(header->struct_count + 1, sizeof(StructType*)); //+1 so an empty file still allocates
+	if (interface_file->loaded_structs == NULL) {
+		printf("ERROR: Failed to allocate %u loaded structs for interface file %s!\n", header->struct_count, path);
+		exit(1);
+	}
+	return interface_file;
+}
+
+void interfaceFile_close(InterfaceFile* interface_file) {
+	if (interface_file == NULL) return;
+
+	munmap(interface_file->map, interface_file->map_size);
+	free(interface_file->loaded_structs);
+	free(interface_file->path);
+	free(interface_file);
+}
+
+static const char* nameText(const InterfaceFile* interface_file, InterfaceName name) {
+	checkRange(interface_file, name.name_offset, name.name_length, interface_file->header->string_data_length);
+	return interface_file->string_data + name.name_offset;
+}
+
+static InterfaceName recordName(const InterfaceFile* interface_file, DeclarationKind kind, uint32_t record) {
+	const InterfaceHeader* header = interface_file->header;
+	switch (kind) {
+		case DECLARATION_STRUCT: checkRange(interface_file, record, 1, header->struct_count); return interface_file->structs[record].name;
+		case DECLARATION_GLOBAL_VARIABLE: checkRange(interface_file, record, 1, header->global_count); return interface_file->globals[record].name;
+		case DECLARATION_FUNCTION: checkRange(interface_file, record, 1, header->function_count); return interface_file->functions[record].name;
+	}
+	corruptFile(interface_file);
+	return (InterfaceName){0};
+}
+
+//record of the declaration of kind named identifier, UINT32_MAX if there is none
+static uint32_t findRecord(const InterfaceFile* interface_file, const char* identifier, DeclarationKind kind) {
+	size_t identifier_length = strlen(identifier);
+	uint32_t hash = hashName(identifier, identifier_length);
+	uint32_t mask = interface_file->header->table_capacity - 1;
+
+	//bounded by the capacity since the file might have no empty slot to stop on
+	uint32_t i = hash & mask;
+	for (uint32_t probe_count = 0; probe_count <= mask; ++probe_count, i = (i + 1) & mask) {
+		const InterfaceSlot* slot = interface_file->table + i;
+		if (slot->record == UINT32_MAX) return UINT32_MAX;
+		if (slot->hash != hash || slot->kind != kind) continue;
+
+		InterfaceName name = recordName(interface_file, kind, slot->record);
+		if (name.name_length == identifier_length && memcmp(nameText(interface_file, name), identifier, identifier_length) == 0) {
+			return slot->record;
+		}
+	}
+	return UINT32_MAX;
+}
+
+static size_t loadName(const InterfaceFile* interface_file, CompilationUnit* compilation_unit, InterfaceName name) {
+	return compilationUnit_getOrAddIdentifierIndex(compilation_unit, nameText(interface_file, name), name.name_length);
+}
+
+static StructType* loadStructRecord(InterfaceFile* interface_file, CompilationUnit* compilation_unit, uint32_t record);
+
+static size_t loadType(InterfaceFile* interface_file, CompilationUnit* compilation_unit, InterfaceType interface_type) {
+	if (interface_type.kind > TYPE_STRUCT) corruptFile(interface_file);
+
+	VariableType type = {.kind=interface_type.kind};
+	if (type.kind != TYPE_STRUCT) {
+		type.data.width = interface_type.data;
+	} else if (interface_type.data == UINT32_MAX) {
+		type.data.struct_type = NULL;
+	} else {
+		type.data.struct_type = loadStructRecord(interface_file, compilation_unit, interface_type.data);
+	}
+	return compilationUnit_getOrAddTypeIndex(compilation_unit, type);
+}
+
+static StructType* loadStructRecord(InterfaceFile* interface_file, CompilationUnit* compilation_unit, uint32_t record) {
+	const InterfaceHeader* header = interface_file->header;
+	checkRange(interface_file, record, 1, header->struct_count);
+	if (interface_file->loaded_structs[record] != NULL) return interface_file->loaded_structs[record];
+
+	const InterfaceStruct* interface_struct = interface_file->structs + record;
+	checkRange(interface_file, interface_struct->first_member, interface_struct->member_count, header->member_count);
+
+	//recorded before the members are loaded so a member referring back to the struct finds it
+	StructType* struct_type = compilationUnit_addImportedStructType(compilation_unit);
+	interface_file->loaded_structs[record] = struct_type;
+	compilationUnit_nameStructType(compilation_unit, struct_type, loadName(interface_file, compilation_unit, interface_struct->name));
+
+	struct_type->member_count = interface_struct->member_count;
+	struct_type->members = arena_allocate(&compilation_unit->declaration_arena, struct_type->member_count * sizeof(StructMember), _Alignof(StructMember));
+	for (size_t i = 0; i < struct_type->member_count; ++i) {
+		const InterfaceVariable* member = interface_file->members + interface_struct->first_member + i;
+		struct_type->members[i].identifier_index = loadName(interface_file, compilation_unit, member->name);
+		struct_type->members[i].type_index = loadType(interface_file, compilation_unit, member->type);
+	}
+	return struct_type;
+}
+
+StructType* interfaceFile_loadStructType(InterfaceFile* interface_file, CompilationUnit* compilation_unit, size_t identifier_index) {
+	uint32_t record = findRecord(interface_file, compilation_unit->identifiers[identifier_index], DECLARATION_STRUCT);
+	if (record == UINT32_MAX) return NULL;
+	return loadStructRecord(interface_file, compilation_unit, record);
+}
+
+Variable* interfaceFile_loadGlobalVariable(InterfaceFile* interface_file, CompilationUnit* compilation_unit, size_t identifier_index) {
+	uint32_t record = findRecord(interface_file, compilation_unit->identifiers[identifier_index], DECLARATION_GLOBAL_VARIABLE);
+	if (record == UINT32_MAX) return NULL;
+
+	Variable* global_variable = compilationUnit_addImportedGlobalVariable(compilation_unit);
+	compilationUnit_nameGlobalVariable(compilation_unit, global_variable, identifier_index);
+	global_variable->type_index = loadType(interface_file, compilation_unit, interface_file->globals[record].type);
+
+	//defined by the imported source, this only declares it
+	global_variable->llvm_stack_pointer = LLVMAddGlobal(
+		compilation_unit->llvm_module,
+		llvmTypeFromTypeIndex(compilation_unit, global_variable->type_index),
+		compilation_unit->identifiers[identifier_index]
+	);
+	return global_variable;
+}
+
+Function* interfaceFile_loadFunction(InterfaceFile* interface_file, CompilationUnit* compilation_unit, size_t identifier_index) {
+	uint32_t record = findRecord(interface_file, compilation_unit->identifiers[identifier_index], DECLARATION_FUNCTION);
+	if (record == UINT32_MAX) return NULL;
+
+	const InterfaceFunction* interface_function = interface_file->functions + record;
+	checkRange(interface_file, interface_function->first_parameter, interface_function->parameter_count, interface_file->header->parameter_count);
+
+	Function* function = compilationUnit_addImportedFunction(compilation_unit);
+	compilationUnit_nameFunction(compilation_unit, function, identifier_index);
+	function->return_type_index = loadType(interface_file, compilation_unit, interface_function->return_type);
+
+	compilationUnit_reserveFunctionParameters(compilation_unit, function, interface_function->parameter_count);
+	for (size_t i = 0; i < interface_function->parameter_count; ++i) {
+		const InterfaceVariable* interface_parameter = interface_file->parameters + interface_function->first_parameter + i;
+		Variable* parameter = compilationUnit_addFunctionParameter(compilation_unit, function);
+		parameter->identifier_index = loadName(interface_file, compilation_unit, interface_parameter->name);
+		parameter->type_index = loadType(interface_file, compilation_unit, interface_parameter->type);
+	}
+
+	//a declaration without a body, the imported source's own object defines it
+	function->llvm_function_type = llvmFunctionTypeFromFunction(compilation_unit, function);
+	function->llvm_function = LLVMAddFunction(
+		compilation_unit->llvm_module,
+		compilation_unit->identifiers[function->identifier_index],
+		function->llvm_function_type
+	);
+	return function;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "compilation_unit.h"
+
+//the declarations of a compiled source file, so files importing it need not lex or parse it again
+//holds the struct layouts, global variables and function signatures the source declared itself, bodies are left out
+//the file is mapped rather than read, and a declaration is only decoded when something looks its name up
+//numbers are written in the byte order of the machine that compiled the source, like the llvm target is assumed to be
+
+typedef struct InterfaceFile InterfaceFile;
+
+//written next to the source, at its path with this appended
+#define INTERFACE_FILE_EXTENSION ".ifc"
+
+//declarations loaded from imports are not passed on
+void interfaceFile_write(const CompilationUnit* compilation_unit, const char* path);
+
+InterfaceFile* interfaceFile_open(const char* path);
+void interfaceFile_close(InterfaceFile* interface_file);
+
+//NULL if the file declares nothing of that kind with the name
+//otherwise the declaration is added to the imported declarations of compilation_unit and named there, so it is only loaded once
+//imported functions get an llvm declaration for the linker to resolve against the object of the imported source
+StructType* interfaceFile_loadStructType(InterfaceFile* interface_file, CompilationUnit* compilation_unit, size_t identifier_index);
+Variable* interfaceFile_loadGlobalVariable(InterfaceFile* interface_file, CompilationUnit* compilation_unit, size_t identifier_index);
+Function* interfaceFile_loadFunction(InterfaceFile* interface_file, CompilationUnit* compilation_unit, size_t identifier_index);
@@ -0,0 +1,230 @@
+#include "interner.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+//the top hash bits pick the shard and the bottom ones the slot, so the shards fill evenly
+#define SHARD_BITS 6
+#define SHARD_COUNT (1 << SHARD_BITS)
+#define INITIAL_TABLE_CAPACITY 64
+
+//index segment i holds 1 << (FIRST_INDEX_SEGMENT_SHIFT + i) identifiers, together just short of every uint32_t index
+#define FIRST_INDEX_SEGMENT_SHIFT 10
+#define INDEX_SEGMENT_COUNT (32 - FIRST_INDEX_SEGMENT_SHIFT)
+#define MAX_INDEX_COUNT (((size_t)1 << FIRST_INDEX_SEGMENT_SHIFT) * (((size_t)1 << INDEX_SEGMENT_COUNT) - 1))
+
+//shards are kept on separate cache lines so threads adding to different shards do not slow each other down
+#define CACHE_LINE_SIZE 64
+
+//the hash and length are kept so most mismatches are found without touching the identifier text
+typedef struct {
+	uint32_t hash;
+	uint32_t length;
+	const char* identifier;
+	//UINT32_MAX for an empty slot, stored last with release so a reader that sees an index sees the rest of the slot
+	uint32_t identifier_index;
+} InternerSlot;
+
+typedef struct {
+	size_t capacity; //power of two
+	InternerSlot slots[];
+} InternerTable;
+
+typedef struct {
+	//loaded by readers without the lock, a grown table is published in its place and the old one stays readable in arena
+	_Alignas(CACHE_LINE_SIZE) InternerTable* table;
+	size_t count;
+	pthread_mutex_t mutex; //held while adding to the shard
+	Arena arena; //identifier strings and every table the shard has had
+} InternerShard;
+
+struct Interner {
+	InternerShard shards[SHARD_COUNT];
+	//identifier at each index, segments are allocated by whichever thread first needs one and never move
+	const char** index_segments[INDEX_SEGMENT_COUNT];
+	_Alignas(CACHE_LINE_SIZE) size_t next_index;
+};
+
+/*
+
+creation/destruction
+
+*/
+
+static InternerTable* createTable(Arena* arena, size_t capacity) {
+	InternerTable* table = arena_allocate(arena, sizeof(InternerTable) + capacity * sizeof(InternerSlot), _Alignof(InternerTable));
+	table->capacity = capacity;
+	//every byte UINT32_MAX marks every slot empty
+	memset(table->slots, 0xff, capacity * sizeof(InternerSlot));
+	return table;
+}
+
+Interner* interner_create(void) {
+	//sizeof is a multiple of the cache line alignment as aligned_alloc requires
+	Interner* interner = aligned_alloc(_Alignof(Interner), sizeof(Interner));
+	if (interner == NULL) {
+		printf("ERROR: Failed to allocate %zu bytes for interner!\n", sizeof(Interner));
+		exit(1);
+	}
+	memset(interner, 0, sizeof(Interner));
+
+	for (size_t i = 0; i < SHARD_COUNT; ++i) {
+		InternerShard* shard = interner->shards + i;
+		pthread_mutex_init(&shard->mutex, NULL);
+		shard->table = createTable(&shard->arena, INITIAL_TABLE_CAPACITY);
+	}
+	return interner;
+}
+
+void interner_destroy(Interner* interner) {
+	if (interner == NULL) return;
+
+	for (size_t i = 0; i < SHARD_COUNT; ++i) {
+		pthread_mutex_destroy(&interner->shards[i].mutex);
+		arena_destroy(&interner->shards[i].arena);
+	}
+	for (size_t i = 0; i < INDEX_SEGMENT_COUNT; ++i) {
+		free(interner->index_segments[i]);
+	}
+	free(interner);
+}
+
+/*
+
+index segments
+
+*/
+
+//same layout as a segmented list, each segment holds as many as all the ones before it plus one first segment
+static size_t indexSegment(size_t index, size_t* offset) {
+	size_t first_segment_length = (size_t)1 << FIRST_INDEX_SEGMENT_SHIFT;
+	size_t shifted_index = (index >> FIRST_INDEX_SEGMENT_SHIFT) + 1;
+	size_t segment = (sizeof(unsigned long long) * 8 - 1) - __builtin_clzll(shifted_index);
+	*offset = index + first_segment_length - (first_segment_length << segment);
+	return segment;
+}
+
+static void setIndexedIdentifier(Interner* interner, size_t index, const char* identifier) {
+	size_t offset;
+	size_t segment = indexSegment(index, &offset);
+
+	const char** entries = __atomic_load_n(&interner->index_segments[segment], __ATOMIC_ACQUIRE);
+	if (entries == NULL) {
+		//threads adding to different shards can race to allocate the same segment, the loser frees its copy
+		size_t entry_count = (size_t)1 << (FIRST_INDEX_SEGMENT_SHIFT + segment);
+		const char** new_entries = calloc(entry_count, sizeof(char*));
+		if (new_entries == NULL) {
+			printf("ERROR: Failed to allocate %zu interner indices!\n", entry_count);
+			exit(1);
+		}
+		if (__atomic_compare_exchange_n(&interner->index_segments[segment], &entries, new_entries, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			entries = new_entries;
+		} else {
+			free(new_entries);
+		}
+	}
+
+	//read by other threads only after they have seen the slot holding index, which is published after this
+	entries[offset] = identifier;
+}
+
+const char* interner_getIdentifier(const Interner* interner, size_t index) {
+	size_t offset;
+	size_t segment = indexSegment(index, &offset);
+	return __atomic_load_n(&interner->index_segments[segment], __ATOMIC_ACQUIRE)[offset];
+}
+
+size_t interner_count(const Interner* interner) {
+	return __atomic_load_n(&interner->next_index, __ATOMIC_RELAXED);
+}
+
+/*
+
+shard tables
+
+*/
+
+//fnv-1a, as compilation units hash their own identifiers
+static uint32_t hashIdentifier(const char* identifier, size_t identifier_length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < identifier_length; ++i) {
+		hash = (hash ^ (unsigned char)identifier[i]) * 16777619u;
+	}
+	return hash;
+}
+
+//slot holding the identifier, or the empty slot it would go in, identifier_index is what the slot held when it was looked at
+//linear probing, tables are never more than half full so this always ends
+static InternerSlot* findSlot(InternerTable* table, const char* identifier, size_t identifier_length, uint32_t hash, uint32_t* identifier_index) {
+	size_t mask = table->capacity - 1;
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		InternerSlot* slot = table->slots + i;
+		*identifier_index = __atomic_load_n(&slot->identifier_index, __ATOMIC_ACQUIRE);
+		if (*identifier_index == UINT32_MAX) return slot;
+		if (slot->hash == hash && slot->length == identifier_length && memcmp(slot->identifier, identifier, identifier_length) == 0) {
+			return slot;
+		}
+	}
+}
+
+//shard lock must be held, readers still probing the old table find anything added since in the new one once they take the lock
+static void growTable(InternerShard* shard) {
+	InternerTable* old_table = shard->table;
+	InternerTable* new_table = createTable(&shard->arena, old_table->capacity * 2);
+
+	//identifiers are all different so each only needs an empty slot
+	size_t mask = new_table->capacity - 1;
+	for (size_t i = 0; i < old_table->capacity; ++i) {
+		if (old_table->slots[i].identifier_index == UINT32_MAX) continue;
+
+		size_t j = old_table->slots[i].hash & mask;
+		while (new_table->slots[j].identifier_index != UINT32_MAX) j = (j + 1) & mask;
+		new_table->slots[j] = old_table->slots[i];
+	}
+
+	__atomic_store_n(&shard->table, new_table, __ATOMIC_RELEASE);
+}
+
+size_t interner_getOrAddIndex(Interner* interner, const char* identifier, size_t identifier_length) {
+	uint32_t hash = hashIdentifier(identifier, identifier_length);
+	InternerShard* shard = interner->shards + (hash >> (32 - SHARD_BITS));
+
+	//most identifiers are already interned, so look before taking the lock
+	uint32_t identifier_index;
+	findSlot(__atomic_load_n(&shard->table, __ATOMIC_ACQUIRE), identifier, identifier_length, hash, &identifier_index);
+	if (identifier_index != UINT32_MAX) return identifier_index;
+
+	//look again with the lock held as another thread may have added it or grown the table since
+	pthread_mutex_lock(&shard->mutex);
+	InternerSlot* slot = findSlot(shard->table, identifier, identifier_length, hash, &identifier_index);
+	if (identifier_index == UINT32_MAX) {
+		size_t new_index = __atomic_fetch_add(&interner->next_index, 1, __ATOMIC_RELAXED);
+		if (identifier_length >= UINT32_MAX || new_index >= MAX_INDEX_COUNT) {
+			printf("ERROR: Too many or too long identifiers in interner!\n");
+			exit(1);
+		}
+
+		const char* copy = arena_copyString(&shard->arena, identifier, identifier_length);
+		setIndexedIdentifier(interner, new_index, copy);
+
+		slot->hash = hash;
+		slot->length = identifier_length;
+		slot->identifier = copy;
+		identifier_index = new_index;
+		__atomic_store_n(&slot->identifier_index, identifier_index, __ATOMIC_RELEASE);
+		++shard->count;
+
+		//keep the table at most half full
+		if (shard->count * 2 > shard->table->capacity) growTable(shard);
+	}
+	pthread_mutex_unlock(&shard->mutex);
+
+	return identifier_index;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+
+//identifier table shared by any number of threads, so identifier indices mean the same thing in every compilation unit using it
+//split into shards by hash, each with its own lock and append only arena for strings
+//looking up an identifier that is already interned takes no lock, only adding one locks its shard
+//indices are handed out from one counter so they are dense across the whole interner, not per shard
+//strings never move or get freed until the interner is destroyed
+
+typedef struct Interner Interner;
+
+Interner* interner_create(void);
+//no thread may be using the interner
+void interner_destroy(Interner* interner);
+
+//safe to call from any thread, identifier does not need to be null terminated
+size_t interner_getOrAddIndex(Interner* interner, const char* identifier, size_t identifier_length);
+//index must have come from interner_getOrAddIndex, on this thread or one that has since synchronised with this one
+const char* interner_getIdentifier(const Interner* interner, size_t index);
+//indices handed out so far, identifiers still being added by other threads are counted
+size_t interner_count(const Interner* interner);
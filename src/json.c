@@ -0,0 +1,366 @@
+#include "json.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//deeper input is rejected rather than risking the stack
+#define MAX_JSON_DEPTH 64
+
+/*
+
+parsing
+
+*/
+
+typedef struct {
+	const char* position;
+	const char* end;
+} JsonParser;
+
+static void* growList(void* list, size_t* capacity, size_t required_count, size_t element_size) {
+	if (required_count <= *capacity) return list;
+
+	size_t new_capacity = *capacity == 0 ? 4 : *capacity * 2;
+	while (new_capacity < required_count) new_capacity *= 2;
+
+	void* new_list = realloc(list, new_capacity * element_size);
+	if (new_list == NULL) {
+		printf("ERROR: Failed to grow json list to %zu elements!\n", new_capacity);
+		exit(1);
+	}
+	*capacity = new_capacity;
+	return new_list;
+}
+
+static void skipWhitespace(JsonParser* parser) {
+	while (parser->position < parser->end) {
+		char c = *parser->position;
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r') return;
+		++parser->position;
+	}
+}
+
+static bool consumeWord(JsonParser* parser, const char* word) {
+	size_t length = strlen(word);
+	if ((size_t)(parser->end - parser->position) < length || memcmp(parser->position, word, length) != 0) return false;
+	parser->position += length;
+	return true;
+}
+
+static bool parseHexQuad(JsonParser* parser, uint32_t* value) {
+	if (parser->end - parser->position < 4) return false;
+
+	*value = 0;
+	for (size_t i = 0; i < 4; ++i) {
+		char c = *parser->position++;
+		*value <<= 4;
+		if (c >= '0' && c <= '9') *value |= c - '0';
+		else if (c >= 'a' && c <= 'f') *value |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') *value |= c - 'A' + 10;
+		else return false;
+	}
+	return true;
+}
+
+static size_t encodeUtf8(uint32_t code_point, char* output) {
+	if (code_point < 0x80) {
+		output[0] = code_point;
+		return 1;
+	}
+	if (code_point < 0x800) {
+		output[0] = 0xc0 | (code_point >> 6);
+		output[1] = 0x80 | (code_point & 0x3f);
+		return 2;
+	}
+	if (code_point < 0x10000) {
+		output[0] = 0xe0 | (code_point >> 12);
+		output[1] = 0x80 | ((code_point >> 6) & 0x3f);
+		output[2] = 0x80 | (code_point & 0x3f);
+		return 3;
+	}
+	output[0] = 0xf0 | (code_point >> 18);
+	output[1] = 0x80 | ((code_point >> 12) & 0x3f);
+	output[2] = 0x80 | ((code_point >> 6) & 0x3f);
+	output[3] = 0x80 | (code_point & 0x3f);
+	return 4;
+}
+
+//starts on the opening quote
+static bool parseString(JsonParser* parser, char** text, size_t* length) {
+	++parser->position;
+
+	//escapes only ever shrink the text
+	const char* start = parser->position;
+	while (parser->position < parser->end && *parser->position != '"') {
+		if (*parser->position == '\\') ++parser->position;
+		++parser->position;
+	}
+	if (parser->position >= parser->end) return false;
+
+	char* output = malloc(parser->position - start + 1);
+	if (output == NULL) {
+		printf("ERROR: Failed to allocate %zu bytes for json string!\n", (size_t)(parser->position - start + 1));
+		exit(1);
+	}
+	parser->position = start;
+
+	size_t output_length = 0;
+	while (*parser->position != '"') {
+		char c = *parser->position++;
+		if (c != '\\') {
+			output[output_length++] = c;
+			continue;
+		}
+
+		switch (*parser->position++) {
+			case '"': output[output_length++] = '"'; break;
+			case '\\': output[output_length++] = '\\'; break;
+			case '/': output[output_length++] = '/'; break;
+			case 'b': output[output_length++] = '\b'; break;
+			case 'f': output[output_length++] = '\f'; break;
+			case 'n': output[output_length++] = '\n'; break;
+			case 'r': output[output_length++] = '\r'; break;
+			case 't': output[output_length++] = '\t'; break;
+
+			case 'u':;
+			uint32_t code_point;
+			if (!parseHexQuad(parser, &code_point)) {
+				free(output);
+				return false;
+			}
+			//surrogate pair, \uXXXX\uXXXX is 12 characters so still fits in 4 bytes
+			uint32_t low_surrogate;
+			if (code_point >= 0xd800 && code_point < 0xdc00 && consumeWord(parser, "\\u")) {
+				if (!parseHexQuad(parser, &low_surrogate)) {
+					free(output);
+					return false;
+				}
+				code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low_surrogate - 0xdc00);
+			}
+			output_length += encodeUtf8(code_point, output + output_length);
+			break;
+
+			default:
+			free(output);
+			return false;
+		}
+	}
+	++parser->position;
+
+	output[output_length] = '\0';
+	*text = output;
+	*length = output_length;
+	return true;
+}
+
+static bool parseValue(JsonParser* parser, JsonValue* value, size_t depth) {
+	memset(value, 0, sizeof(*value));
+	if (depth > MAX_JSON_DEPTH) return false;
+
+	skipWhitespace(parser);
+	if (parser->position >= parser->end) return false;
+
+	switch (*parser->position) {
+		case 'n': value->type = JSON_NULL; return consumeWord(parser, "null");
+		case 't': value->type = JSON_BOOL; value->data.boolean = true; return consumeWord(parser, "true");
+		case 'f': value->type = JSON_BOOL; value->data.boolean = false; return consumeWord(parser, "false");
+
+		case '"':
+		if (!parseString(parser, &value->data.string.text, &value->data.string.length)) return false;
+		value->type = JSON_STRING;
+		return true;
+
+		case '[':;
+		++parser->position;
+		value->type = JSON_ARRAY;
+		size_t element_capacity = 0;
+		skipWhitespace(parser);
+		if (consumeWord(parser, "]")) return true;
+		while (true) {
+			value->data.array.elements = growList(value->data.array.elements, &element_capacity, value->data.array.count + 1, sizeof(JsonValue));
+			JsonValue* element = value->data.array.elements + value->data.array.count;
+			//counted before parsing so a failure still frees the partial element
+			++value->data.array.count;
+			if (!parseValue(parser, element, depth + 1)) return false;
+
+			skipWhitespace(parser);
+			if (consumeWord(parser, "]")) return true;
+			if (!consumeWord(parser, ",")) return false;
+		}
+
+		case '{':;
+		++parser->position;
+		value->type = JSON_OBJECT;
+		size_t member_capacity = 0;
+		skipWhitespace(parser);
+		if (consumeWord(parser, "}")) return true;
+		while (true) {
+			value->data.object.members = growList(value->data.object.members, &member_capacity, value->data.object.count + 1, sizeof(JsonMember));
+			JsonMember* member = value->data.object.members + value->data.object.count;
+			memset(member, 0, sizeof(*member));
+			++value->data.object.count;
+
+			skipWhitespace(parser);
+			size_t key_length;
+			if (parser->position >= parser->end || *parser->position != '"') return false;
+			if (!parseString(parser, &member->key, &key_length)) return false;
+			skipWhitespace(parser);
+			if (!consumeWord(parser, ":")) return false;
+			if (!parseValue(parser, &member->value, depth + 1)) return false;
+
+			skipWhitespace(parser);
+			if (consumeWord(parser, "}")) return true;
+			if (!consumeWord(parser, ",")) return false;
+		}
+
+		default:;
+		//numbers, strtod would accept more than json does but nothing sends that
+		char number_text[64];
+		size_t number_length = 0;
+		while (parser->position + number_length < parser->end && number_length + 1 < sizeof(number_text)) {
+			char c = parser->position[number_length];
+			if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') break;
+			number_text[number_length] = c;
+			++number_length;
+		}
+		number_text[number_length] = '\0';
+
+		char* number_end;
+		value->type = JSON_NUMBER;
+		value->data.number = strtod(number_text, &number_end);
+		if (number_length == 0 || number_end != number_text + number_length) return false;
+		parser->position += number_length;
+		return true;
+	}
+}
+
+bool jsonValue_parse(const char* text, size_t length, JsonValue* value) {
+	JsonParser parser = {text, text + length};
+	bool valid = parseValue(&parser, value, 0);
+
+	skipWhitespace(&parser);
+	if (!valid || parser.position != parser.end) {
+		jsonValue_destroy(value);
+		return false;
+	}
+	return true;
+}
+
+void jsonValue_destroy(JsonValue* value) {
+	switch (value->type) {
+		case JSON_STRING:
+		free(value->data.string.text);
+		break;
+
+		case JSON_ARRAY:
+		for (size_t i = 0; i < value->data.array.count; ++i) {
+			jsonValue_destroy(value->data.array.elements + i);
+		}
+		free(value->data.array.elements);
+		break;
+
+		case JSON_OBJECT:
+		for (size_t i = 0; i < value->data.object.count; ++i) {
+			free(value->data.object.members[i].key);
+			jsonValue_destroy(&value->data.object.members[i].value);
+		}
+		free(value->data.object.members);
+		break;
+
+		default: break;
+	}
+	memset(value, 0, sizeof(*value));
+}
+
+/*
+
+lookup
+
+*/
+
+const JsonValue* jsonValue_member(const JsonValue* value, const char* key) {
+	if (value == NULL || value->type != JSON_OBJECT) return NULL;
+
+	for (size_t i = 0; i < value->data.object.count; ++i) {
+		if (strcmp(value->data.object.members[i].key, key) == 0) return &value->data.object.members[i].value;
+	}
+	return NULL;
+}
+
+const char* jsonValue_string(const JsonValue* value, size_t* length) {
+	if (value == NULL || value->type != JSON_STRING) return NULL;
+
+	if (length != NULL) *length = value->data.string.length;
+	return value->data.string.text;
+}
+
+double jsonValue_number(const JsonValue* value, double fallback) {
+	if (value == NULL || value->type != JSON_NUMBER) return fallback;
+	return value->data.number;
+}
+
+/*
+
+output
+
+*/
+
+static void reserve(JsonBuffer* buffer, size_t extra_length) {
+	//+1 for null character
+	buffer->data = growList(buffer->data, &buffer->capacity, buffer->length + extra_length + 1, sizeof(char));
+}
+
+void jsonBuffer_append(JsonBuffer* buffer, const char* format, ...) {
+	va_list arguments;
+	va_start(arguments, format);
+	va_list arguments_copy;
+	va_copy(arguments_copy, arguments);
+
+	int length = vsnprintf(NULL, 0, format, arguments);
+	reserve(buffer, length);
+	vsnprintf(buffer->data + buffer->length, length + 1, format, arguments_copy);
+	buffer->length += length;
+
+	va_end(arguments_copy);
+	va_end(arguments);
+}
+
+void jsonBuffer_appendString(JsonBuffer* buffer, const char* text, size_t length) {
+	//worst case every character becomes \u00XX
+	reserve(buffer, length * 6 + 2);
+
+	char* output = buffer->data + buffer->length;
+	*output++ = '"';
+	for (size_t i = 0; i < length; ++i) {
+		unsigned char c = text[i];
+		switch (c) {
+			case '"': *output++ = '\\'; *output++ = '"'; break;
+			case '\\': *output++ = '\\'; *output++ = '\\'; break;
+			case '\n': *output++ = '\\'; *output++ = 'n'; break;
+			case '\r': *output++ = '\\'; *output++ = 'r'; break;
+			case '\t': *output++ = '\\'; *output++ = 't'; break;
+
+			default:
+			if (c < 0x20) {
+				output += sprintf(output, "\\u%04x", c);
+			} else {
+				*output++ = c;
+			}
+			break;
+		}
+	}
+	*output++ = '"';
+	*output = '\0';
+
+	buffer->length = output - buffer->data;
+}
+
+void jsonBuffer_destroy(JsonBuffer* buffer) {
+	free(buffer->data);
+	memset(buffer, 0, sizeof(*buffer));
+}
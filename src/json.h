@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//just enough json for the language server protocol
+
+typedef enum {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT,
+} JsonType;
+
+typedef struct JsonValue JsonValue;
+typedef struct JsonMember JsonMember;
+
+struct JsonValue {
+	JsonType type;
+	union {
+		bool boolean;
+		double number;
+		struct {
+			char* text; //escapes handled and null-terminated, may also contain nulls
+			size_t length;
+		} string;
+		struct {
+			JsonValue* elements;
+			size_t count;
+		} array;
+		struct {
+			JsonMember* members;
+			size_t count;
+		} object;
+	} data;
+};
+
+struct JsonMember {
+	char* key; //null-terminated
+	JsonValue value;
+};
+
+//returns false if text is not valid json, value is then JSON_NULL and needs no destroying
+bool jsonValue_parse(const char* text, size_t length, JsonValue* value);
+void jsonValue_destroy(JsonValue* value);
+
+//all return NULL if value is NULL or not of the right type, so lookups can be chained
+const JsonValue* jsonValue_member(const JsonValue* value, const char* key);
+const char* jsonValue_string(const JsonValue* value, size_t* length);
+//fallback is returned instead of NULL
+double jsonValue_number(const JsonValue* value, double fallback);
+
+//output is built up in a growable buffer
+typedef struct {
+	char* data; //null-terminated
+	size_t length;
+	size_t capacity;
+} JsonBuffer;
+
+//printf style
+void jsonBuffer_append(JsonBuffer* buffer, const char* format, ...);
+//quotes and escapes text
+void jsonBuffer_appendString(JsonBuffer* buffer, const char* text, size_t length);
+void jsonBuffer_destroy(JsonBuffer* buffer);
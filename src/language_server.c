@@ -0,0 +1,1022 @@
+#include "language_server.h"
+
+#include <inttypes.h>
+#include <llvm-c/Core.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "compilation_unit.h"
+#include "json.h"
+#include "parser_blocks.h"
+#include "parser_top_level.h"
+#include "token.h"
+#include "tokeniser.h"
+
+//json-rpc error codes
+#define ERROR_PARSE -32700
+#define ERROR_METHOD_NOT_FOUND -32601
+
+//the parser reports errors by printing them and exiting, so checks run in a child process with its output captured
+//this line is printed before each function is checked, so an error can be put on the function it came from
+#define CHECK_MARKER "\x1e" "check "
+//a check stuck on bad input is given up on after this many seconds
+#define CHECK_TIME_LIMIT 2
+
+/*
+
+documents
+
+*/
+
+//a variable or parameter, token indices are relative to the fn keyword so they hold while the function is unchanged
+typedef struct {
+	size_t identifier_index; //in compilation unit member "identifiers"
+	size_t token_index;
+	size_t scope_end_token_index; //visible from token_index up to and including this
+} Declaration;
+
+//everything kept about one top level function between edits
+typedef struct {
+	size_t token_index; //of the fn keyword
+	size_t end_token_index; //closing brace of the body
+	uint32_t offset; //of the fn keyword
+	uint32_t end_offset; //just past the closing brace
+	size_t identifier_index; //in compilation unit member "identifiers", NULL_INDEX if the name is missing
+
+	Declaration* declarations;
+	size_t declaration_count;
+
+	uint64_t declaration_hash; //see hashDeclaration
+	bool dirty; //body has changed since it was last checked
+	char* diagnostic; //NULL if the last check passed
+	size_t diagnostic_offset; //relative to offset
+} FunctionSummary;
+
+typedef struct {
+	char* uri;
+	CompilationUnit compilation_unit;
+	Tokeniser tokeniser;
+
+	FunctionSummary* functions; //in source order
+	size_t function_count;
+
+	//the top level is parsed into compilation_unit once it is known to succeed, then only bodies are checked
+	bool top_level_dirty;
+	//error outside of any function body, found by the top level parse
+	char* top_level_diagnostic;
+	size_t top_level_diagnostic_offset;
+} Document;
+
+typedef struct {
+	LLVMContextRef llvm_context;
+	Document* documents;
+	size_t document_count;
+	size_t document_capacity;
+	bool shutdown_requested;
+} LanguageServer;
+
+static void freeFunctionSummary(FunctionSummary* function) {
+	free(function->declarations);
+	free(function->diagnostic);
+	memset(function, 0, sizeof(*function));
+}
+
+//starts on the fn keyword, returns the index of the opening brace of the body, or of the token that ended the search
+//parentheses are not jumped, whether one is matched can depend on any later token and the result must not
+static size_t findFunctionBody(const TokenList* token_list, size_t token_index) {
+	for (++token_index; token_index < token_list->token_count; ++token_index) {
+		switch (token_list->tokens[token_index].type) {
+			case TOKEN_BRACE_LEFT:
+			case TOKEN_FN:
+			case TOKEN_STRUCT:
+			case TOKEN_IMPORT:
+			case TOKEN_EOF:
+			return token_index;
+
+			default: break;
+		}
+	}
+	return token_list->token_count - 1;
+}
+
+static void findDeclarations(const TokenList* token_list, FunctionSummary* function) {
+	size_t declaration_capacity = 0;
+	function->declarations = NULL;
+	function->declaration_count = 0;
+
+	size_t* open_braces = NULL;
+	size_t open_brace_count = 0;
+	size_t open_brace_capacity = 0;
+
+	size_t function_end = function->end_token_index - function->token_index;
+	const Token* tokens = token_list->tokens + function->token_index;
+	for (size_t i = 1; i < function_end; ++i) {
+		switch (tokens[i].type) {
+			case TOKEN_BRACE_LEFT:
+			if (open_brace_count >= open_brace_capacity) {
+				open_brace_capacity = open_brace_capacity == 0 ? 16 : open_brace_capacity * 2;
+				open_braces = realloc(open_braces, open_brace_capacity * sizeof(open_braces[0]));
+				if (open_braces == NULL) {
+					printf("ERROR: Failed to grow scope stack!\n");
+					exit(1);
+				}
+			}
+			open_braces[open_brace_count++] = i;
+			break;
+
+			case TOKEN_BRACE_RIGHT:
+			if (open_brace_count > 0) --open_brace_count;
+			break;
+
+			case TOKEN_IDENTIFIER:
+			if (tokens[i + 1].type != TOKEN_COLON) break;
+
+			if (function->declaration_count >= declaration_capacity) {
+				declaration_capacity = declaration_capacity == 0 ? 16 : declaration_capacity * 2;
+				function->declarations = realloc(function->declarations, declaration_capacity * sizeof(Declaration));
+				if (function->declarations == NULL) {
+					printf("ERROR: Failed to grow function declarations!\n");
+					exit(1);
+				}
+			}
+			//parameters are in no braces and last the whole function
+			size_t scope_end = function_end;
+			if (open_brace_count > 0) {
+				uint32_t closing_brace = tokens[open_braces[open_brace_count - 1]].payload;
+				if (closing_brace != TOKEN_NO_MATCH) scope_end = closing_brace - function->token_index;
+			}
+			function->declarations[function->declaration_count++] = (Declaration){tokens[i].payload, i, scope_end};
+			break;
+
+			default: break;
+		}
+	}
+
+	free(open_braces);
+}
+
+//hash of everything parseTopLevel reads of a function, which is its tokens up to the body and whether the body is closed
+//payloads that are indices into the token list or its side tables move with edits so only the type of those is used
+static uint64_t hashDeclaration(const TokenList* token_list, size_t token_index, size_t body_index) {
+	//fnv-1a
+	uint64_t hash = 0xcbf29ce484222325;
+	for (size_t i = token_index; i <= body_index; ++i) {
+		const Token* token = token_list->tokens + i;
+		uint64_t value = token->type;
+		switch (token->type) {
+			case TOKEN_IDENTIFIER:
+			case TOKEN_INTEGER_TYPE:
+			case TOKEN_UNSIGNED_TYPE:
+			case TOKEN_FLOAT_TYPE:
+			case TOKEN_CHARACTER_TYPE:
+			value |= (uint64_t)token->payload << 8;
+			break;
+
+			default: break;
+		}
+		hash = (hash ^ value) * 0x100000001b3;
+	}
+
+	const Token* body = token_list->tokens + body_index;
+	bool body_closed = body->type == TOKEN_BRACE_LEFT && body->payload != TOKEN_NO_MATCH;
+	return (hash ^ body_closed) * 0x100000001b3;
+}
+
+//first summary with end_token_index at or after token_index, summaries are in order so this is a binary search
+static size_t firstFunctionEndingFrom(const FunctionSummary* functions, size_t function_count, size_t token_index) {
+	size_t low = 0;
+	size_t high = function_count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (functions[middle].end_token_index < token_index) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+//updates the function summaries after the token list edit, jumping over bodies with the delimiter matches
+//an opening delimiter is matched by the tokens after it alone, so summaries ending before the edit are unchanged
+//and once the walk reaches a summary starting after the edit it and every later one are unchanged but moved
+//summaries in between are made again and marked dirty, the top level is marked dirty unless the edit stayed in one body
+static void summariseFunctions(Document* document, TokenListEdit edit, size_t removed_length, size_t inserted_length) {
+	const TokenList* token_list = &document->compilation_unit.token_list;
+	FunctionSummary* old_functions = document->functions;
+	size_t old_function_count = document->function_count;
+
+	//the token after a function without a body decided where it ended, so that has to be before the edit too
+	size_t kept_count = firstFunctionEndingFrom(old_functions, old_function_count, edit.first_token > 0 ? edit.first_token - 1 : 0);
+	size_t new_edit_end = edit.first_token + edit.inserted_count;
+
+	FunctionSummary* functions = NULL;
+	size_t function_count = 0;
+	size_t function_capacity = 0;
+
+	bool walked_top_level = false;
+	size_t moved_index = kept_count;
+	size_t token_index = kept_count > 0 ? old_functions[kept_count - 1].end_token_index + 1 : 0;
+	while (token_index < token_list->token_count) {
+		//back in step with the old summaries
+		if (token_index >= new_edit_end) {
+			size_t old_token_index = token_index - edit.inserted_count + edit.removed_count;
+			while (moved_index < old_function_count && old_functions[moved_index].token_index < old_token_index) {
+				++moved_index;
+			}
+			if (moved_index < old_function_count && old_functions[moved_index].token_index == old_token_index) break;
+		}
+
+		//anything else found here is a change to the top level
+		const Token* token = token_list->tokens + token_index;
+		if (token->type != TOKEN_FN) walked_top_level = true;
+		if (token->type != TOKEN_FN && token->type != TOKEN_STRUCT) {
+			++token_index;
+			continue;
+		}
+
+		size_t body_index = findFunctionBody(token_list, token_index);
+		const Token* body = token_list->tokens + body_index;
+		size_t end_index = body_index;
+		if (body->type == TOKEN_BRACE_LEFT) {
+			//an unclosed body runs to the end of the file
+			end_index = body->payload != TOKEN_NO_MATCH ? body->payload : token_list->token_count - 1;
+		} else if (body_index > token_index) {
+			//no body, stop before whatever ended the search
+			--end_index;
+		}
+
+		if (token->type == TOKEN_FN) {
+			if (function_count >= function_capacity) {
+				function_capacity = function_capacity == 0 ? 4 : function_capacity * 2;
+				functions = realloc(functions, function_capacity * sizeof(FunctionSummary));
+				if (functions == NULL) {
+					printf("ERROR: Failed to grow function summaries!\n");
+					exit(1);
+				}
+			}
+			FunctionSummary* function = functions + function_count;
+			++function_count;
+			memset(function, 0, sizeof(*function));
+
+			const Token* end = token_list->tokens + end_index;
+			function->token_index = token_index;
+			function->end_token_index = end_index;
+			function->offset = token->offset_in_source;
+			function->end_offset = end->offset_in_source + tokenList_tokenLength(token_list, end);
+			function->identifier_index = token[1].type == TOKEN_IDENTIFIER ? token[1].payload : NULL_INDEX;
+			function->declaration_hash = hashDeclaration(token_list, token_index, body_index);
+			function->dirty = true;
+			findDeclarations(token_list, function);
+		}
+
+		token_index = end_index + 1;
+	}
+	if (token_index >= token_list->token_count) moved_index = old_function_count;
+
+	//the top level is unchanged if only one function was made again, with the same declaration and the edit inside it
+	//its end has to move with the edit too, or tokens outside it changed sides
+	size_t remade_count = moved_index - kept_count;
+	bool top_level_unchanged = !walked_top_level && remade_count == 1 && function_count == 1 &&
+		functions[0].declaration_hash == old_functions[kept_count].declaration_hash &&
+		functions[0].token_index == old_functions[kept_count].token_index &&
+		functions[0].token_index <= edit.first_token && new_edit_end <= functions[0].end_token_index + 1 &&
+		functions[0].end_token_index + edit.removed_count == old_functions[kept_count].end_token_index + edit.inserted_count;
+	if (!top_level_unchanged) document->top_level_dirty = true;
+
+	//replace the summaries made again and move the rest
+	for (size_t i = kept_count; i < moved_index; ++i) {
+		freeFunctionSummary(old_functions + i);
+	}
+	size_t moved_count = old_function_count - moved_index;
+	size_t new_function_count = kept_count + function_count + moved_count;
+	if (new_function_count > old_function_count) {
+		old_functions = realloc(old_functions, new_function_count * sizeof(FunctionSummary));
+		if (old_functions == NULL) {
+			printf("ERROR: Failed to grow function summaries!\n");
+			exit(1);
+		}
+	}
+	FunctionSummary* moved_functions = old_functions + kept_count + function_count;
+	memmove(moved_functions, old_functions + moved_index, moved_count * sizeof(FunctionSummary));
+	for (size_t i = 0; i < moved_count; ++i) {
+		moved_functions[i].token_index = moved_functions[i].token_index + edit.inserted_count - edit.removed_count;
+		moved_functions[i].end_token_index = moved_functions[i].end_token_index + edit.inserted_count - edit.removed_count;
+		moved_functions[i].offset = moved_functions[i].offset + inserted_length - removed_length;
+		moved_functions[i].end_offset = moved_functions[i].end_offset + inserted_length - removed_length;
+	}
+	if (function_count > 0) memcpy(old_functions + kept_count, functions, function_count * sizeof(FunctionSummary));
+	free(functions);
+
+	document->functions = old_functions;
+	document->function_count = new_function_count;
+}
+
+static Document* findDocument(LanguageServer* server, const char* uri) {
+	if (uri == NULL) return NULL;
+
+	for (size_t i = 0; i < server->document_count; ++i) {
+		if (strcmp(server->documents[i].uri, uri) == 0) return server->documents + i;
+	}
+	return NULL;
+}
+
+static void closeDocument(LanguageServer* server, Document* document) {
+	for (size_t i = 0; i < document->function_count; ++i) {
+		freeFunctionSummary(document->functions + i);
+	}
+	free(document->functions);
+	free(document->top_level_diagnostic);
+	free(document->uri);
+	compilationUnit_destroy(&document->compilation_unit);
+
+	//keep the list packed
+	--server->document_count;
+	*document = server->documents[server->document_count];
+}
+
+//replaces removed_length bytes of the source at edit_offset with text, then relexes around the edit
+static void editDocument(Document* document, size_t edit_offset, size_t removed_length, const char* text, size_t inserted_length) {
+	CompilationUnit* compilation_unit = &document->compilation_unit;
+	if (edit_offset > compilation_unit->source_length) edit_offset = compilation_unit->source_length;
+	if (removed_length > compilation_unit->source_length - edit_offset) removed_length = compilation_unit->source_length - edit_offset;
+
+	size_t new_length = compilation_unit->source_length - removed_length + inserted_length;
+	size_t tail_length = compilation_unit->source_length - edit_offset - removed_length;
+	if (new_length > compilation_unit->source_length) {
+		char* new_source = realloc(compilation_unit->source, new_length + SOURCE_PADDING);
+		if (new_source == NULL) {
+			printf("ERROR: Failed to grow source of %s to %zu bytes!\n", document->uri, new_length);
+			exit(1);
+		}
+		compilation_unit->source = new_source;
+	}
+	char* source = compilation_unit->source;
+	memmove(source + edit_offset + inserted_length, source + edit_offset + removed_length, tail_length);
+	memcpy(source + edit_offset, text, inserted_length);
+	memset(source + new_length, 0, SOURCE_PADDING);
+	compilation_unit->source_length = new_length;
+
+	TokenListEdit edit = tokeniser_retokenise(&document->tokeniser, compilation_unit, edit_offset, removed_length, inserted_length);
+	summariseFunctions(document, edit, removed_length, inserted_length);
+}
+
+/*
+
+checking
+
+*/
+
+//first occurrence of text in [start, end), NULL if there is none
+static const char* findText(const char* start, const char* end, const char* text) {
+	size_t text_length = strlen(text);
+	for (const char* position = start; position + text_length <= end; ++position) {
+		if (memcmp(position, text, text_length) == 0) return position;
+	}
+	return NULL;
+}
+
+//returns the message from the output of one failed check and sets offset to where it was found
+//offset is left alone if the output has no index, and the message is about the exit status if it has no error
+static char* diagnosticFromOutput(const char* output, const char* output_end, int status, size_t* offset) {
+	const char* message = "Check failed";
+	if (WIFSIGNALED(status)) {
+		message = WTERMSIG(status) == SIGALRM ? "Check took too long and was stopped" : "Compiler crashed while checking this";
+	}
+	size_t message_length = strlen(message);
+
+	const char* error = findText(output, output_end, "ERROR: ");
+	if (error != NULL) {
+		message = error + strlen("ERROR: ");
+		const char* line_end = memchr(message, '\n', output_end - message);
+		message_length = (line_end != NULL ? line_end : output_end) - message;
+	}
+
+	const char* index = findText(output, output_end, "index: ");
+	if (index != NULL) *offset = strtoull(index + strlen("index: "), NULL, 10);
+
+	char* diagnostic = malloc(message_length + 1);
+	if (diagnostic == NULL) {
+		printf("ERROR: Failed to allocate memory for diagnostic!\n");
+		exit(1);
+	}
+	memcpy(diagnostic, message, message_length);
+	diagnostic[message_length] = '\0';
+	return diagnostic;
+}
+
+//checks the dirty functions from first_dirty on in a child process, after the top level parse if asked for
+//returns its output and sets status to how it exited
+static char* runChecks(Document* document, bool parse_top_level, const size_t* dirty_functions, size_t dirty_count, size_t first_dirty, size_t* output_length, int* status) {
+	int pipe_descriptors[2];
+	if (pipe(pipe_descriptors) != 0) {
+		printf("ERROR: Failed to create pipe for checking %s!\n", document->uri);
+		exit(1);
+	}
+
+	//anything buffered would otherwise be sent twice
+	fflush(stdout);
+	pid_t child = fork();
+	if (child < 0) {
+		printf("ERROR: Failed to fork for checking %s!\n", document->uri);
+		exit(1);
+	}
+
+	if (child == 0) {
+		//the child must not touch the connection to the client
+		close(STDIN_FILENO);
+		close(pipe_descriptors[0]);
+		dup2(pipe_descriptors[1], STDOUT_FILENO);
+		close(pipe_descriptors[1]);
+		alarm(CHECK_TIME_LIMIT);
+
+		CompilationUnit* compilation_unit = &document->compilation_unit;
+		if (parse_top_level) parseTopLevel(compilation_unit);
+		for (size_t i = first_dirty; i < dirty_count; ++i) {
+			//flushed so it is not lost if the check crashes
+			printf(CHECK_MARKER "%zu\n", i);
+			fflush(stdout);
+			parseFunctionBlock(compilation_unit, document->functions[dirty_functions[i]].token_index);
+		}
+		fflush(stdout);
+		_exit(0);
+	}
+
+	close(pipe_descriptors[1]);
+	char* output = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+	while (true) {
+		if (length + 4096 > capacity) {
+			capacity = capacity == 0 ? 4096 * 2 : capacity * 2;
+			output = realloc(output, capacity);
+			if (output == NULL) {
+				printf("ERROR: Failed to grow check output!\n");
+				exit(1);
+			}
+		}
+		ssize_t read_result = read(pipe_descriptors[0], output + length, capacity - length - 1);
+		if (read_result <= 0) break;
+		length += read_result;
+	}
+	output[length] = '\0';
+	close(pipe_descriptors[0]);
+
+	waitpid(child, status, 0);
+	*output_length = length;
+	return output;
+}
+
+//checks the top level if it changed and every dirty function body, keeping the diagnostics found
+static void checkDocument(Document* document) {
+	size_t* dirty_functions = malloc((document->function_count + 1) * sizeof(size_t));
+	if (dirty_functions == NULL) {
+		printf("ERROR: Failed to allocate memory for dirty functions!\n");
+		exit(1);
+	}
+	size_t dirty_count = 0;
+	for (size_t i = 0; i < document->function_count; ++i) {
+		if (!document->functions[i].dirty) continue;
+		dirty_functions[dirty_count++] = i;
+		free(document->functions[i].diagnostic);
+		document->functions[i].diagnostic = NULL;
+	}
+
+	//the top level is first parsed in a child since a failing parse exits
+	//once that passes it is parsed again here and kept, so later checks only parse bodies
+	bool parse_top_level = document->top_level_dirty;
+	if (parse_top_level) {
+		free(document->top_level_diagnostic);
+		document->top_level_diagnostic = NULL;
+		compilationUnit_clearDeclarations(&document->compilation_unit);
+	}
+
+	//each failed check stops its child, so carry on from the function after it
+	size_t first_dirty = 0;
+	while (parse_top_level || first_dirty < dirty_count) {
+		size_t output_length;
+		int status;
+		char* output = runChecks(document, parse_top_level, dirty_functions, dirty_count, first_dirty, &output_length, &status);
+		bool passed = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		if (parse_top_level && (passed || findText(output, output + output_length, CHECK_MARKER) != NULL)) {
+			parseTopLevel(&document->compilation_unit);
+			document->top_level_dirty = false;
+			parse_top_level = false;
+		}
+		if (passed) {
+			free(output);
+			break;
+		}
+		const char* output_end = output + output_length;
+
+		//find the function the output ends in
+		const char* failure_output = output;
+		size_t failed_function = NULL_INDEX;
+		const char* marker = output;
+		while ((marker = findText(marker, output_end, CHECK_MARKER)) != NULL) {
+			marker += strlen(CHECK_MARKER);
+			char* number_end;
+			failed_function = strtoull(marker, &number_end, 10);
+			failure_output = number_end;
+		}
+
+		if (failed_function == NULL_INDEX) {
+			//nothing can be checked without the top level
+			document->top_level_diagnostic_offset = 0;
+			document->top_level_diagnostic = diagnosticFromOutput(failure_output, output_end, status, &document->top_level_diagnostic_offset);
+			free(output);
+			break;
+		}
+
+		FunctionSummary* function = document->functions + dirty_functions[failed_function];
+		size_t offset = function->offset;
+		function->diagnostic = diagnosticFromOutput(failure_output, output_end, status, &offset);
+		function->diagnostic_offset = offset >= function->offset ? offset - function->offset : 0;
+		function->dirty = false;
+		free(output);
+
+		first_dirty = failed_function + 1;
+	}
+
+	//with the top level failing the rest stay dirty to be checked once it is fixed
+	if (document->top_level_diagnostic == NULL) {
+		for (size_t i = 0; i < dirty_count; ++i) {
+			document->functions[dirty_functions[i]].dirty = false;
+		}
+	}
+	free(dirty_functions);
+}
+
+/*
+
+positions
+
+*/
+
+//language server positions are 0 based, characters are counted as bytes
+static size_t offsetFromPosition(const Document* document, const JsonValue* position) {
+	const TokenList* token_list = &document->compilation_unit.token_list;
+	double line = jsonValue_number(jsonValue_member(position, "line"), 0);
+	double character = jsonValue_number(jsonValue_member(position, "character"), 0);
+	if (line < 0) line = 0;
+	if (character < 0) character = 0;
+
+	if ((size_t)line >= token_list->line_count) return token_list->source_length;
+	size_t line_start = token_list->line_starts[(size_t)line];
+	size_t line_end = token_list->source_length;
+	if ((size_t)line + 1 < token_list->line_count) line_end = token_list->line_starts[(size_t)line + 1] - 1;
+
+	size_t offset = line_start + (size_t)character;
+	return offset < line_end ? offset : line_end;
+}
+
+static void appendPosition(JsonBuffer* buffer, const TokenList* token_list, size_t offset) {
+	size_t line, column;
+	tokenList_lineAndColumn(token_list, offset, &line, &column);
+	jsonBuffer_append(buffer, "{\"line\":%zu,\"character\":%zu}", line - 1, column - 1);
+}
+
+static void appendRange(JsonBuffer* buffer, const TokenList* token_list, size_t start_offset, size_t end_offset) {
+	jsonBuffer_append(buffer, "{\"start\":");
+	appendPosition(buffer, token_list, start_offset);
+	jsonBuffer_append(buffer, ",\"end\":");
+	appendPosition(buffer, token_list, end_offset);
+	jsonBuffer_append(buffer, "}");
+}
+
+//index of the token under offset, a cursor just after a token counts as on it, NULL_INDEX if there is none
+static size_t tokenAtOffset(const TokenList* token_list, size_t offset) {
+	size_t low = 0;
+	size_t high = token_list->token_count;
+	while (high - low > 1) {
+		size_t middle = low + (high - low) / 2;
+		if (token_list->tokens[middle].offset_in_source <= offset) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+
+	const Token* token = token_list->tokens + low;
+	if (token->type == TOKEN_EOF || token->offset_in_source > offset) return NULL_INDEX;
+	if (offset > token->offset_in_source + tokenList_tokenLength(token_list, token)) return NULL_INDEX;
+	return low;
+}
+
+//index of the function whose tokens include token_index, NULL_INDEX if it is outside every function
+static size_t functionAtToken(const Document* document, size_t token_index) {
+	size_t low = 0;
+	size_t high = document->function_count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (document->functions[middle].end_token_index < token_index) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	if (low >= document->function_count || document->functions[low].token_index > token_index) return NULL_INDEX;
+	return low;
+}
+
+//index of the token that declares the identifier at token_index, NULL_INDEX if it is not found
+//the innermost variable or parameter in scope wins, otherwise a function of that name
+static size_t findDefinition(const Document* document, size_t token_index) {
+	const TokenList* token_list = &document->compilation_unit.token_list;
+	size_t identifier_index = token_list->tokens[token_index].payload;
+
+	size_t function_index = functionAtToken(document, token_index);
+	if (function_index != NULL_INDEX) {
+		const FunctionSummary* function = document->functions + function_index;
+		size_t relative_index = token_index - function->token_index;
+
+		const Declaration* best = NULL;
+		for (size_t i = 0; i < function->declaration_count; ++i) {
+			const Declaration* declaration = function->declarations + i;
+			if (declaration->identifier_index != identifier_index) continue;
+			if (declaration->token_index > relative_index || declaration->scope_end_token_index < relative_index) continue;
+			if (best == NULL || declaration->token_index > best->token_index) best = declaration;
+		}
+		if (best != NULL) return function->token_index + best->token_index;
+	}
+
+	for (size_t i = 0; i < document->function_count; ++i) {
+		if (document->functions[i].identifier_index == identifier_index) return document->functions[i].token_index + 1;
+	}
+	return NULL_INDEX;
+}
+
+/*
+
+messages
+
+*/
+
+//reads one message body, NULL once input has ended
+static char* readMessage(size_t* length) {
+	//headers, only the length matters
+	char header[256];
+	size_t content_length = 0;
+	bool has_length = false;
+	while (true) {
+		if (fgets(header, sizeof(header), stdin) == NULL) return NULL;
+		if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+			if (has_length) break;
+			continue;
+		}
+		if (strncmp(header, "Content-Length:", strlen("Content-Length:")) == 0) {
+			content_length = strtoull(header + strlen("Content-Length:"), NULL, 10);
+			has_length = true;
+		}
+	}
+
+	char* body = malloc(content_length + 1);
+	if (body == NULL) {
+		printf("ERROR: Failed to allocate %zu bytes for message!\n", content_length + 1);
+		exit(1);
+	}
+	if (fread(body, 1, content_length, stdin) != content_length) {
+		free(body);
+		return NULL;
+	}
+	body[content_length] = '\0';
+	*length = content_length;
+	return body;
+}
+
+static void sendMessage(const JsonBuffer* body) {
+	printf("Content-Length: %zu\r\n\r\n", body->length);
+	fwrite(body->data, 1, body->length, stdout);
+	fflush(stdout);
+}
+
+static void appendId(JsonBuffer* buffer, const JsonValue* id) {
+	size_t id_length;
+	const char* id_string = jsonValue_string(id, &id_length);
+	if (id_string != NULL) {
+		jsonBuffer_appendString(buffer, id_string, id_length);
+	} else if (id != NULL && id->type == JSON_NUMBER) {
+		jsonBuffer_append(buffer, "%" PRId64, (int64_t)id->data.number);
+	} else {
+		jsonBuffer_append(buffer, "null");
+	}
+}
+
+//result is already json
+static void sendResult(const JsonValue* id, const char* result) {
+	JsonBuffer body = {0};
+	jsonBuffer_append(&body, "{\"jsonrpc\":\"2.0\",\"id\":");
+	appendId(&body, id);
+	jsonBuffer_append(&body, ",\"result\":%s}", result);
+	sendMessage(&body);
+	jsonBuffer_destroy(&body);
+}
+
+static void sendError(const JsonValue* id, int code, const char* message) {
+	JsonBuffer body = {0};
+	jsonBuffer_append(&body, "{\"jsonrpc\":\"2.0\",\"id\":");
+	appendId(&body, id);
+	jsonBuffer_append(&body, ",\"error\":{\"code\":%d,\"message\":", code);
+	jsonBuffer_appendString(&body, message, strlen(message));
+	jsonBuffer_append(&body, "}}");
+	sendMessage(&body);
+	jsonBuffer_destroy(&body);
+}
+
+static void appendDiagnostic(JsonBuffer* buffer, const TokenList* token_list, size_t offset, const char* message, bool first) {
+	size_t end_offset = offset;
+	size_t token_index = tokenAtOffset(token_list, offset);
+	if (token_index != NULL_INDEX) end_offset += tokenList_tokenLength(token_list, token_list->tokens + token_index);
+
+	jsonBuffer_append(buffer, "%s{\"range\":", first ? "" : ",");
+	appendRange(buffer, token_list, offset, end_offset);
+	jsonBuffer_append(buffer, ",\"severity\":1,\"source\":\"compiler-3\",\"message\":");
+	jsonBuffer_appendString(buffer, message, strlen(message));
+	jsonBuffer_append(buffer, "}");
+}
+
+//document may be NULL to clear the diagnostics of uri
+static void publishDiagnostics(const char* uri, const Document* document) {
+	JsonBuffer body = {0};
+	jsonBuffer_append(&body, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+	jsonBuffer_appendString(&body, uri, strlen(uri));
+	jsonBuffer_append(&body, ",\"diagnostics\":[");
+
+	if (document != NULL) {
+		const TokenList* token_list = &document->compilation_unit.token_list;
+		bool first = true;
+		//bodies cannot be checked while the top level fails, so what they found before is held back
+		if (document->top_level_diagnostic != NULL) {
+			appendDiagnostic(&body, token_list, document->top_level_diagnostic_offset, document->top_level_diagnostic, first);
+			first = false;
+		}
+		for (size_t i = 0; i < document->function_count && document->top_level_diagnostic == NULL; ++i) {
+			const FunctionSummary* function = document->functions + i;
+			if (function->diagnostic == NULL) continue;
+			appendDiagnostic(&body, token_list, function->offset + function->diagnostic_offset, function->diagnostic, first);
+			first = false;
+		}
+	}
+
+	jsonBuffer_append(&body, "]}}");
+	sendMessage(&body);
+	jsonBuffer_destroy(&body);
+}
+
+/*
+
+methods
+
+*/
+
+static void initialize(const JsonValue* id) {
+	//changes are sent as ranges so only the edited part is relexed
+	sendResult(id, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},\"hoverProvider\":true,\"definitionProvider\":true}}");
+}
+
+static void didOpen(LanguageServer* server, const JsonValue* params) {
+	const JsonValue* text_document = jsonValue_member(params, "textDocument");
+	const char* uri = jsonValue_string(jsonValue_member(text_document, "uri"), NULL);
+	size_t text_length;
+	const char* text = jsonValue_string(jsonValue_member(text_document, "text"), &text_length);
+	if (uri == NULL || text == NULL) return;
+
+	Document* document = findDocument(server, uri);
+	if (document != NULL) closeDocument(server, document);
+
+	if (server->document_count >= server->document_capacity) {
+		server->document_capacity = server->document_capacity == 0 ? 4 : server->document_capacity * 2;
+		server->documents = realloc(server->documents, server->document_capacity * sizeof(Document));
+		if (server->documents == NULL) {
+			printf("ERROR: Failed to grow open documents!\n");
+			exit(1);
+		}
+	}
+	document = server->documents + server->document_count;
+	++server->document_count;
+	memset(document, 0, sizeof(*document));
+
+	document->uri = strdup(uri);
+	if (document->uri == NULL) {
+		printf("ERROR: Failed to allocate memory for document uri!\n");
+		exit(1);
+	}
+	document->compilation_unit = compilationUnit_createFromText(uri, text, text_length, server->llvm_context);
+
+	//an empty token list is lexed whole
+	TokenListEdit edit = tokeniser_retokenise(&document->tokeniser, &document->compilation_unit, 0, 0, text_length);
+	document->top_level_dirty = true;
+	summariseFunctions(document, edit, 0, text_length);
+
+	checkDocument(document);
+	publishDiagnostics(uri, document);
+}
+
+static void didChange(LanguageServer* server, const JsonValue* params) {
+	const char* uri = jsonValue_string(jsonValue_member(jsonValue_member(params, "textDocument"), "uri"), NULL);
+	Document* document = findDocument(server, uri);
+	const JsonValue* changes = jsonValue_member(params, "contentChanges");
+	if (document == NULL || changes == NULL || changes->type != JSON_ARRAY) return;
+
+	//each change applies to the text left by the one before
+	for (size_t i = 0; i < changes->data.array.count; ++i) {
+		const JsonValue* change = changes->data.array.elements + i;
+		size_t text_length;
+		const char* text = jsonValue_string(jsonValue_member(change, "text"), &text_length);
+		if (text == NULL) continue;
+
+		const JsonValue* range = jsonValue_member(change, "range");
+		if (range == NULL) {
+			editDocument(document, 0, document->compilation_unit.source_length, text, text_length);
+			continue;
+		}
+
+		size_t start_offset = offsetFromPosition(document, jsonValue_member(range, "start"));
+		size_t end_offset = offsetFromPosition(document, jsonValue_member(range, "end"));
+		if (end_offset < start_offset) end_offset = start_offset;
+		editDocument(document, start_offset, end_offset - start_offset, text, text_length);
+	}
+
+	checkDocument(document);
+	publishDiagnostics(uri, document);
+}
+
+static void didClose(LanguageServer* server, const JsonValue* params) {
+	const char* uri = jsonValue_string(jsonValue_member(jsonValue_member(params, "textDocument"), "uri"), NULL);
+	Document* document = findDocument(server, uri);
+	if (document == NULL) return;
+
+	publishDiagnostics(uri, NULL);
+	closeDocument(server, document);
+}
+
+//finds the document and token the request points at, returns false if there is no token there
+static bool findRequestToken(LanguageServer* server, const JsonValue* params, Document** document, size_t* token_index) {
+	const char* uri = jsonValue_string(jsonValue_member(jsonValue_member(params, "textDocument"), "uri"), NULL);
+	*document = findDocument(server, uri);
+	if (*document == NULL) return false;
+
+	size_t offset = offsetFromPosition(*document, jsonValue_member(params, "position"));
+	*token_index = tokenAtOffset(&(*document)->compilation_unit.token_list, offset);
+	return *token_index != NULL_INDEX;
+}
+
+//functions show their signature, variables and parameters their declaration and literals their value
+static void hover(LanguageServer* server, const JsonValue* id, const JsonValue* params) {
+	Document* document;
+	size_t token_index;
+	if (!findRequestToken(server, params, &document, &token_index)) {
+		sendResult(id, "null");
+		return;
+	}
+	const TokenList* token_list = &document->compilation_unit.token_list;
+	const Token* token = token_list->tokens + token_index;
+
+	JsonBuffer contents = {0};
+	switch (token->type) {
+		case TOKEN_IDENTIFIER:;
+		size_t definition_index = findDefinition(document, token_index);
+		if (definition_index == NULL_INDEX || definition_index == 0) break;
+
+		//declaration text runs from the start of the declaration to the end of its type or signature
+		size_t first_index = definition_index;
+		size_t last_index = definition_index + 2;
+		if (token_list->tokens[definition_index - 1].type == TOKEN_FN && token_list->tokens[definition_index + 1].type == TOKEN_PARENTHESIS_LEFT) {
+			--first_index;
+			last_index = findFunctionBody(token_list, first_index) - 1;
+		}
+		if (last_index >= token_list->token_count - 1) last_index = token_list->token_count - 2;
+		const Token* first = token_list->tokens + first_index;
+		const Token* last = token_list->tokens + last_index;
+		size_t end_offset = last->offset_in_source + tokenList_tokenLength(token_list, last);
+		jsonBuffer_appendString(&contents, token_list->source + first->offset_in_source, end_offset - first->offset_in_source);
+		break;
+
+		case TOKEN_INTEGER_LITERAL:;
+		char integer_text[64];
+		snprintf(integer_text, sizeof(integer_text), "integer literal %" PRIu64, tokenList_integer(token_list, token));
+		jsonBuffer_appendString(&contents, integer_text, strlen(integer_text));
+		break;
+
+		case TOKEN_REAL_LITERAL:;
+		char real_text[64];
+		snprintf(real_text, sizeof(real_text), "real literal %.17g", tokenList_real(token_list, token));
+		jsonBuffer_appendString(&contents, real_text, strlen(real_text));
+		break;
+
+		default: break;
+	}
+
+	if (contents.length == 0) {
+		sendResult(id, "null");
+		return;
+	}
+
+	JsonBuffer result = {0};
+	jsonBuffer_append(&result, "{\"contents\":{\"kind\":\"plaintext\",\"value\":%s},\"range\":", contents.data);
+	appendRange(&result, token_list, token->offset_in_source, token->offset_in_source + tokenList_tokenLength(token_list, token));
+	jsonBuffer_append(&result, "}");
+	sendResult(id, result.data);
+	jsonBuffer_destroy(&result);
+	jsonBuffer_destroy(&contents);
+}
+
+static void definition(LanguageServer* server, const JsonValue* id, const JsonValue* params) {
+	Document* document;
+	size_t token_index;
+	if (!findRequestToken(server, params, &document, &token_index)) {
+		sendResult(id, "null");
+		return;
+	}
+	const TokenList* token_list = &document->compilation_unit.token_list;
+
+	size_t definition_index = NULL_INDEX;
+	if (token_list->tokens[token_index].type == TOKEN_IDENTIFIER) definition_index = findDefinition(document, token_index);
+	if (definition_index == NULL_INDEX) {
+		sendResult(id, "null");
+		return;
+	}
+
+	const Token* definition_token = token_list->tokens + definition_index;
+	JsonBuffer result = {0};
+	jsonBuffer_append(&result, "{\"uri\":");
+	jsonBuffer_appendString(&result, document->uri, strlen(document->uri));
+	jsonBuffer_append(&result, ",\"range\":");
+	appendRange(
+		&result,
+		token_list,
+		definition_token->offset_in_source,
+		definition_token->offset_in_source + tokenList_tokenLength(token_list, definition_token)
+	);
+	jsonBuffer_append(&result, "}");
+	sendResult(id, result.data);
+	jsonBuffer_destroy(&result);
+}
+
+//returns true once the client says to exit
+static bool handleMessage(LanguageServer* server, const JsonValue* message) {
+	const char* method = jsonValue_string(jsonValue_member(message, "method"), NULL);
+	const JsonValue* id = jsonValue_member(message, "id");
+	const JsonValue* params = jsonValue_member(message, "params");
+	if (method == NULL) return false; //a response, nothing is ever requested of the client
+
+	if (strcmp(method, "initialize") == 0) {
+		initialize(id);
+	} else if (strcmp(method, "shutdown") == 0) {
+		server->shutdown_requested = true;
+		sendResult(id, "null");
+	} else if (strcmp(method, "exit") == 0) {
+		return true;
+	} else if (strcmp(method, "textDocument/didOpen") == 0) {
+		didOpen(server, params);
+	} else if (strcmp(method, "textDocument/didChange") == 0) {
+		didChange(server, params);
+	} else if (strcmp(method, "textDocument/didClose") == 0) {
+		didClose(server, params);
+	} else if (strcmp(method, "textDocument/hover") == 0) {
+		hover(server, id, params);
+	} else if (strcmp(method, "textDocument/definition") == 0) {
+		definition(server, id, params);
+	} else if (id != NULL) {
+		//unknown notifications are ignored
+		sendError(id, ERROR_METHOD_NOT_FOUND, "Method not found");
+	}
+	return false;
+}
+
+int languageServer_run(LLVMContextRef llvm_context) {
+	LanguageServer server;
+	memset(&server, 0, sizeof(server));
+	server.llvm_context = llvm_context;
+
+	bool exit_requested = false;
+	while (!exit_requested) {
+		size_t length;
+		char* body = readMessage(&length);
+		if (body == NULL) break;
+
+		JsonValue message;
+		if (jsonValue_parse(body, length, &message)) {
+			exit_requested = handleMessage(&server, &message);
+			jsonValue_destroy(&message);
+		} else {
+			sendError(NULL, ERROR_PARSE, "Parse error");
+		}
+		free(body);
+	}
+
+	while (server.document_count > 0) {
+		closeDocument(&server, server.documents);
+	}
+	free(server.documents);
+
+	//exiting without a shutdown request is an error
+	return exit_requested && server.shutdown_requested ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <llvm-c/Core.h>
+
+//language server protocol over standard input and output, returns the exit code once the client says to exit
+//open documents stay lexed between edits, so an edit only relexes the tokens near it and rechecks the function bodies it touches
+int languageServer_run(LLVMContextRef llvm_context);
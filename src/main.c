@@ -2,18 +2,45 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "compilation_unit.h"
+#include "interface_file.h"
+#include "language_server.h"
+#include "memory_stats.h"
 #include "parser_blocks.h"
 #include "parser_top_level.h"
+#include "tokeniser.h"
 
 int main(int argc, char* argv[]) {
 	//handle command line arguments
-	if (argc != 2) {
+	//usage: [--parallel-lex] [--mem-stats] source_path
+	//   or: --language-server
+	//a source path of "-" reads standard input and writes the result to standard output
+	if (argc == 2 && strcmp(argv[1], "--language-server") == 0) {
+		LLVMContextRef llvm_context = LLVMContextCreate();
+		int exit_code = languageServer_run(llvm_context);
+		LLVMContextDispose(llvm_context);
+		return exit_code;
+	}
+
+	bool parallel_lex = false;
+	bool mem_stats = false;
+	for (int i = 1; i < argc - 1; ++i) {
+		if (strcmp(argv[i], "--parallel-lex") == 0) {
+			parallel_lex = true;
+		} else if (strcmp(argv[i], "--mem-stats") == 0) {
+			mem_stats = true;
+		} else {
+			printf("ERROR: Unknown argument %s!\n", argv[i]);
+			return 1;
+		}
+	}
+	if (argc < 2) {
 		printf("ERROR: Incorrect argument count!\n");
 		return 1;
 	}
-	char* source_path = argv[1];
+	char* source_path = argv[argc - 1];
 
 	//setup LLVM context
 	LLVMContextRef llvm_context = LLVMContextCreate();
@@ -23,20 +50,43 @@ int main(int argc, char* argv[]) {
 	LLVMSetTarget(compilation_unit.llvm_module, "x86_64-pc-linux-gnu"); //assume target
 
 	//compile
+	if (parallel_lex) {
+		long core_count = sysconf(_SC_NPROCESSORS_ONLN);
+		tokeniseParallel(&compilation_unit, core_count > 0 ? (size_t)core_count : 1);
+	} else {
+		tokenise(&compilation_unit);
+	}
+	//stats go to standard error since standard output may be carrying the result
+	if (mem_stats) memoryStats_print(&compilation_unit, "tokenise", stderr);
 	parseTopLevel(&compilation_unit);
+	if (mem_stats) memoryStats_print(&compilation_unit, "parseTopLevel", stderr);
 	parseBlocks(&compilation_unit);
+	if (mem_stats) memoryStats_print(&compilation_unit, "parseBlocks", stderr);
 
 	//output result
-	char output_path[strlen(source_path) + sizeof(".ll")];
-	strcpy(output_path, source_path);
-	strcat(output_path, ".ll");
-
-	char* ll_error_message;
-	bool ll_failure = LLVMPrintModuleToFile(compilation_unit.llvm_module, output_path, &ll_error_message);
-	if (ll_failure) {
-		printf("ERROR: Failed to output llvm code: %s\n", ll_error_message);
-    	LLVMDisposeMessage(ll_error_message);
+	if (strcmp(source_path, "-") == 0) {
+		char* ll_code = LLVMPrintModuleToString(compilation_unit.llvm_module);
+		fputs(ll_code, stdout);
+		LLVMDisposeMessage(ll_code);
+	} else {
+		char output_path[strlen(source_path) + sizeof(".ll")];
+		strcpy(output_path, source_path);
+		strcat(output_path, ".ll");
+
+		char* ll_error_message;
+		bool ll_failure = LLVMPrintModuleToFile(compilation_unit.llvm_module, output_path, &ll_error_message);
+		if (ll_failure) {
+			printf("ERROR: Failed to output llvm code: %s\n", ll_error_message);
+			LLVMDisposeMessage(ll_error_message);
+		}
+
+		//declarations for files that import this one
+		char interface_path[strlen(source_path) + sizeof(INTERFACE_FILE_EXTENSION)];
+		strcpy(interface_path, source_path);
+		strcat(interface_path, INTERFACE_FILE_EXTENSION);
+		interfaceFile_write(&compilation_unit, interface_path);
 	}
+	if (mem_stats) memoryStats_print(&compilation_unit, "output", stderr);
 
 	//free resources
 	compilationUnit_destroy(&compilation_unit);
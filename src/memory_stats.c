@@ -0,0 +1,174 @@
+#include "memory_stats.h"
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "arena.h"
+#include "compilation_unit.h"
+#include "segmented_list.h"
+#include "token.h"
+
+typedef enum {
+	MEMORY_IDENTIFIERS,
+	MEMORY_STRUCTS,
+	MEMORY_FUNCTIONS,
+	MEMORY_SCOPES,
+	MEMORY_VARIABLES,
+	MEMORY_TYPES,
+	MEMORY_SYMBOLS,
+	MEMORY_TOKENS,
+	MEMORY_TOKEN_PAYLOADS,
+	MEMORY_SOURCE,
+
+	MEMORY_CATEGORY_COUNT,
+} MemoryCategory;
+
+static const char* const MEMORY_CATEGORY_NAMES[MEMORY_CATEGORY_COUNT] = {
+	[MEMORY_IDENTIFIERS] = "identifiers",
+	[MEMORY_STRUCTS] = "structs",
+	[MEMORY_FUNCTIONS] = "functions",
+	[MEMORY_SCOPES] = "scopes",
+	[MEMORY_VARIABLES] = "variables",
+	[MEMORY_TYPES] = "types",
+	[MEMORY_SYMBOLS] = "symbols",
+	[MEMORY_TOKENS] = "tokens",
+	[MEMORY_TOKEN_PAYLOADS] = "token payloads",
+	[MEMORY_SOURCE] = "source",
+};
+
+//the declaration and identifier categories live in the unit's two arenas, their lists and strings are carved out of
+//shared arena blocks rather than allocated on their own, so only their bytes are counted and the arena lines give the blocks
+static const bool MEMORY_CATEGORY_IN_ARENA[MEMORY_CATEGORY_COUNT] = {
+	[MEMORY_IDENTIFIERS] = true,
+	[MEMORY_STRUCTS] = true,
+	[MEMORY_FUNCTIONS] = true,
+	[MEMORY_SCOPES] = true,
+	[MEMORY_VARIABLES] = true,
+	[MEMORY_TYPES] = true,
+	[MEMORY_SYMBOLS] = true,
+};
+
+typedef struct {
+	size_t bytes;
+	size_t allocations; //only counted for categories outside the arenas
+} MemoryUsage;
+
+//list with a malloc allocation of its own
+static void addList(MemoryUsage* usage, const void* list, size_t capacity, size_t element_size) {
+	if (list == NULL) return;
+	usage->bytes += capacity * element_size;
+	++usage->allocations;
+}
+
+static void addArenaList(MemoryUsage* usage, size_t capacity, size_t element_size) {
+	usage->bytes += capacity * element_size;
+}
+
+//every segment plus the table pointing at them
+static void addSegmentedList(MemoryUsage* usage, const SegmentedList* list, size_t element_size) {
+	if (list->segments == NULL) return;
+	usage->bytes += segmentedList_capacity(list) * element_size + list->segment_count * sizeof(void*);
+}
+
+static void addCompilationUnitLists(const CompilationUnit* compilation_unit, MemoryUsage usage[MEMORY_CATEGORY_COUNT]) {
+	//identifiers, strings in a shared interner belong to it rather than the unit
+	addArenaList(&usage[MEMORY_IDENTIFIERS], compilation_unit->identifier_capacity, sizeof(char*));
+	addArenaList(&usage[MEMORY_IDENTIFIERS], compilation_unit->identifier_table_capacity, sizeof(IdentifierSlot));
+	for (size_t i = 0; compilation_unit->interner == NULL && i < compilation_unit->identifier_count; ++i) {
+		usage[MEMORY_IDENTIFIERS].bytes += strlen(compilation_unit->identifiers[i]) + 1;
+	}
+
+	//declarations
+	addSegmentedList(&usage[MEMORY_STRUCTS], &compilation_unit->structs, sizeof(StructType));
+	addSegmentedList(&usage[MEMORY_VARIABLES], &compilation_unit->global_variables, sizeof(Variable));
+	addSegmentedList(&usage[MEMORY_FUNCTIONS], &compilation_unit->functions, sizeof(Function));
+	for (size_t i = 0; i < compilation_unit->functions.count; ++i) {
+		const Function* function = compilationUnit_getFunction(compilation_unit, i);
+		addSegmentedList(&usage[MEMORY_VARIABLES], &function->parameters, sizeof(Variable));
+		addSegmentedList(&usage[MEMORY_SCOPES], &function->scopes, sizeof(Scope));
+		for (size_t j = 0; j < function->scopes.count; ++j) {
+			addSegmentedList(&usage[MEMORY_VARIABLES], &compilationUnit_getFunctionScope(function, j)->variables, sizeof(Variable));
+		}
+	}
+	addSegmentedList(&usage[MEMORY_STRUCTS], &compilation_unit->imported_structs, sizeof(StructType));
+	addSegmentedList(&usage[MEMORY_VARIABLES], &compilation_unit->imported_global_variables, sizeof(Variable));
+	addSegmentedList(&usage[MEMORY_FUNCTIONS], &compilation_unit->imported_functions, sizeof(Function));
+	for (size_t i = 0; i < compilation_unit->imported_functions.count; ++i) {
+		const Function* function = segmentedList_get(&compilation_unit->imported_functions, i, sizeof(Function));
+		addSegmentedList(&usage[MEMORY_VARIABLES], &function->parameters, sizeof(Variable));
+	}
+	addArenaList(&usage[MEMORY_TYPES], compilation_unit->type_capacity, sizeof(InternedType));
+
+	//lookup tables
+	const SymbolTable* symbol_table = &compilation_unit->symbol_table;
+	addArenaList(&usage[MEMORY_SYMBOLS], compilation_unit->top_level_symbol_capacity, sizeof(TopLevelSymbol));
+	addArenaList(&usage[MEMORY_SYMBOLS], symbol_table->symbol_capacity, sizeof(Symbol));
+	addArenaList(&usage[MEMORY_SYMBOLS], symbol_table->undo_capacity, sizeof(SymbolUndo));
+	addArenaList(&usage[MEMORY_SYMBOLS], symbol_table->scope_capacity, sizeof(size_t));
+
+	//tokens and the side tables their payloads index
+	const TokenList* token_list = &compilation_unit->token_list;
+	addList(&usage[MEMORY_TOKENS], token_list->tokens, token_list->token_capacity, sizeof(Token));
+	addList(&usage[MEMORY_TOKENS], token_list->line_starts, token_list->line_capacity, sizeof(uint32_t));
+	addList(&usage[MEMORY_TOKEN_PAYLOADS], token_list->integers, token_list->integer_capacity, sizeof(uint64_t));
+	addList(&usage[MEMORY_TOKEN_PAYLOADS], token_list->reals, token_list->real_capacity, sizeof(double));
+	addList(&usage[MEMORY_TOKEN_PAYLOADS], token_list->strings, token_list->string_capacity, sizeof(TokenString));
+	addList(&usage[MEMORY_TOKEN_PAYLOADS], token_list->string_data, token_list->string_data_capacity, sizeof(char));
+
+	addList(&usage[MEMORY_SOURCE], compilation_unit->source_path, strlen(compilation_unit->source_path) + 1, sizeof(char));
+	addList(&usage[MEMORY_SOURCE], compilation_unit->source, compilation_unit->source_length + SOURCE_PADDING, sizeof(char));
+}
+
+//bytes malloc is currently handing out to the whole process, false if the c library cannot say
+static bool getHeapBytes(size_t* heap_bytes) {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+	struct mallinfo2 heap_info = mallinfo2();
+	*heap_bytes = heap_info.uordblks + heap_info.hblkhd;
+	return true;
+#else
+	*heap_bytes = 0;
+	return false;
+#endif
+}
+
+void memoryStats_print(const CompilationUnit* compilation_unit, const char* phase, FILE* output) {
+	MemoryUsage usage[MEMORY_CATEGORY_COUNT];
+	memset(usage, 0, sizeof(usage));
+	addCompilationUnitLists(compilation_unit, usage);
+
+	struct rusage resource_usage;
+	long peak_rss = getrusage(RUSAGE_SELF, &resource_usage) == 0 ? resource_usage.ru_maxrss : 0;
+	fprintf(output, "memory after %s, peak rss %ld KiB\n", phase, peak_rss);
+
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		if (MEMORY_CATEGORY_IN_ARENA[i]) {
+			fprintf(output, "\t%-18s %12zu bytes %10s\n", MEMORY_CATEGORY_NAMES[i], usage[i].bytes, "in arena");
+		} else {
+			fprintf(output, "\t%-18s %12zu bytes %10zu allocations\n", MEMORY_CATEGORY_NAMES[i], usage[i].bytes, usage[i].allocations);
+		}
+	}
+
+	//lists grown in an arena leave their old copies behind, so the arenas hold more than the lists above
+	size_t identifier_blocks, identifier_reserved, identifier_used;
+	size_t declaration_blocks, declaration_reserved, declaration_used;
+	arena_getUsage(&compilation_unit->identifier_arena, &identifier_blocks, &identifier_reserved, &identifier_used);
+	arena_getUsage(&compilation_unit->declaration_arena, &declaration_blocks, &declaration_reserved, &declaration_used);
+	fprintf(output, "\t%-18s %12zu bytes %10zu blocks, %zu bytes used\n", "identifier arena", identifier_reserved, identifier_blocks, identifier_used);
+	fprintf(output, "\t%-18s %12zu bytes %10zu blocks, %zu bytes used\n", "declaration arena", declaration_reserved, declaration_blocks, declaration_used);
+
+	//llvm allocates through malloc, so it is whatever of the heap the unit does not account for
+	size_t heap_bytes;
+	if (!getHeapBytes(&heap_bytes)) {
+		fprintf(output, "\t%-18s %12s\n", "llvm", "unknown");
+		return;
+	}
+	size_t unit_heap_bytes = identifier_reserved + declaration_reserved;
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		if (!MEMORY_CATEGORY_IN_ARENA[i]) unit_heap_bytes += usage[i].bytes;
+	}
+	fprintf(output, "\t%-18s %12zu bytes\n", "llvm", heap_bytes > unit_heap_bytes ? heap_bytes - unit_heap_bytes : 0);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "compilation_unit.h"
+
+//memory held by a compilation unit, broken down by what it is for
+//everything is worked out from the lists when asked for, so compiling this in costs nothing until it is used
+//allocations are the separate malloc blocks each category outside the arenas is made of
+//categories in the arenas only report their bytes, the arena lines count the blocks they share, llvm has no way to report its own
+void memoryStats_print(const CompilationUnit* compilation_unit, const char* phase, FILE* output);
@@ -31,24 +31,28 @@ typedef struct {
 		//for constants and resulting intermediates
 		struct {
 			LLVMValueRef value;
-			VariableType type;
+			size_t type_index; //in compilation unit member "types"
 		} llvm_value;
 	} operand_value;
 } ExpressionOperand;
 
-static VariableType getOperandValueType(ExpressionOperand operand) {
+static size_t getOperandTypeIndex(ExpressionOperand operand) {
 	switch (operand.operand_type) {
-		case OPERAND_NULL: return (VariableType){.kind=TYPE_NONE};
+		case OPERAND_NULL: return TYPE_INDEX_NONE;
 
 		case OPERAND_VARIABLE:
-		return operand.operand_value.variable->type;
+		return operand.operand_value.variable->type_index;
 
 		case OPERAND_CONSTANT:
 		case OPERAND_INTERMEDIATE:
-		return operand.operand_value.llvm_value.type;
+		return operand.operand_value.llvm_value.type_index;
 	}
 }
 
+static TypeKind getOperandTypeKind(CompilationUnit* compilation_unit, ExpressionOperand operand) {
+	return compilation_unit->types[getOperandTypeIndex(operand)].type.kind;
+}
+
 static LLVMValueRef getOperandValue(CompilationUnit* compilation_unit, LLVMBuilderRef llvm_builder, ExpressionOperand operand) {
 	switch (operand.operand_type) {
 		case OPERAND_NULL: return NULL;
@@ -67,7 +71,7 @@ static LLVMValueRef getOperandValue(CompilationUnit* compilation_unit, LLVMBuild
 
 		return LLVMBuildLoad2(
 			llvm_builder,
-			operand.operand_value.variable->llvm_type,
+			llvmTypeFromTypeIndex(compilation_unit, operand.operand_value.variable->type_index),
 			operand.operand_value.variable->llvm_stack_pointer,
 			name
 		);
@@ -79,40 +83,36 @@ static LLVMValueRef getOperandValue(CompilationUnit* compilation_unit, LLVMBuild
 static ExpressionOperand parseExpressionOperand(
 	CompilationUnit* compilation_unit,
 	Function* current_function,
-	size_t current_scope_index,
-	VariableType expected_type
+	size_t expected_type_index
 ) {
 	ExpressionOperand expression_operand;
 	memset(&expression_operand, 0, sizeof(expression_operand));
+	TypeKind expected_kind = compilation_unit->types[expected_type_index].type.kind;
 
-	switch (currentToken().type) {
+	switch (currentTokenType()) {
 		//variable or function call
 		case TOKEN_IDENTIFIER:
-		if (nextToken().type == TOKEN_PARENTHESIS_LEFT) {
+		if (nextTokenType() == TOKEN_PARENTHESIS_LEFT) {
 			//TODO function calls
 			printf("ERROR: Attempted to parse currently unsupported function call!\n");
 			exit(1);
 		}
 		//is either variable, or struct member/function call
 		//both of these require knowing the varaiable
-		size_t variable_identifier_index = compilationUnit_getOrAddIdentifierIndex(compilation_unit, currentToken().data.identifier);
-		Variable* variable = compilationUnit_findVariableFromScope(
-			compilation_unit,
-			current_function,
-			current_scope_index,
-			variable_identifier_index
-		);
+		size_t variable_identifier_index = currentToken()->payload;
+		Variable* variable = compilationUnit_findVariable(compilation_unit, current_function, variable_identifier_index);
 		if (variable == NULL) {
 			printf("ERROR: Use of undeclared variable!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//type checking
-		if (variable->type.kind != expected_type.kind && expected_type.kind != TYPE_NONE) {
+		TypeKind variable_kind = compilation_unit->types[variable->type_index].type.kind;
+		if (variable_kind != expected_kind && expected_kind != TYPE_NONE) {
 			printf("ERROR: Mismatched variable type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//if struct, check members
-		if (variable->type.kind == TYPE_STRUCT) {
+		if (variable_kind == TYPE_STRUCT) {
 			//TODO support structs
 			printf("ERROR: Attempted to parse currently unsupported struct!\n");
 			exit(1);
@@ -128,59 +128,59 @@ static ExpressionOperand parseExpressionOperand(
 		//literals
 		case TOKEN_INTEGER_LITERAL:
 		//ensure literal type matches expected type
-		if (expected_type.kind != TYPE_INT && expected_type.kind != TYPE_UNSIGNED && expected_type.kind != TYPE_NONE) {
+		if (expected_kind != TYPE_INT && expected_kind != TYPE_UNSIGNED && expected_kind != TYPE_NONE) {
 			printf("ERROR: Mismatched literal type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//default to 64 bit
-		if (expected_type.kind == TYPE_NONE) {
-			expected_type.kind = TYPE_INT;
-			expected_type.data.width = 64;
+		if (expected_kind == TYPE_NONE) {
+			expected_type_index = TYPE_INDEX_INT;
+			expected_kind = TYPE_INT;
 		}
 		//fill operand data
 		expression_operand.operand_type = OPERAND_CONSTANT;
-		expression_operand.operand_value.llvm_value.type = expected_type;
+		expression_operand.operand_value.llvm_value.type_index = expected_type_index;
 		expression_operand.operand_value.llvm_value.value = LLVMConstInt(
-			llvmTypeFromVariableType(compilation_unit->llvm_context, expected_type),
-			currentToken().data.integer,
-			expected_type.kind != TYPE_UNSIGNED
+			llvmTypeFromTypeIndex(compilation_unit, expected_type_index),
+			tokenList_integer(&compilation_unit->token_list, currentToken()),
+			expected_kind != TYPE_UNSIGNED
 		);
 		incrementToken();
 		break;
 		
 		case TOKEN_REAL_LITERAL:
 		//ensure literal type matches expected type
-		if (expected_type.kind != TYPE_FLOAT && expected_type.kind != TYPE_NONE) {
+		if (expected_kind != TYPE_FLOAT && expected_kind != TYPE_NONE) {
 			printf("ERROR: Mismatched literal type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//default to 64 bit
-		if (expected_type.kind == TYPE_NONE) {
-			expected_type.kind = TYPE_FLOAT;
-			expected_type.data.width = 64;
+		if (expected_kind == TYPE_NONE) {
+			expected_type_index = TYPE_INDEX_FLOAT;
+			expected_kind = TYPE_FLOAT;
 		}
 		//fill operand data
 		expression_operand.operand_type = OPERAND_CONSTANT;
-		expression_operand.operand_value.llvm_value.type = expected_type;
+		expression_operand.operand_value.llvm_value.type_index = expected_type_index;
 		expression_operand.operand_value.llvm_value.value = LLVMConstReal(
-			llvmTypeFromVariableType(compilation_unit->llvm_context, expected_type),
-			currentToken().data.real
+			llvmTypeFromTypeIndex(compilation_unit, expected_type_index),
+			tokenList_real(&compilation_unit->token_list, currentToken())
 		);
 		incrementToken();
 		break;
 
 		case TOKEN_CHARACTER_LITERAL:
 		//ensure literal type matches expected type
-		if (expected_type.kind != TYPE_CHAR && expected_type.kind != TYPE_NONE) {
+		if (expected_kind != TYPE_CHAR && expected_kind != TYPE_NONE) {
 			printf("ERROR: Mismatched literal type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//fill operand data
 		expression_operand.operand_type = OPERAND_CONSTANT;
-		expression_operand.operand_value.llvm_value.type = (VariableType){.kind=TYPE_CHAR, .data.width=32};
+		expression_operand.operand_value.llvm_value.type_index = TYPE_INDEX_CHAR;
 		expression_operand.operand_value.llvm_value.value = LLVMConstInt(
 			LLVMInt32TypeInContext(compilation_unit->llvm_context),
-			currentToken().data.character,
+			currentToken()->payload,
 			false
 		);
 		incrementToken();
@@ -188,17 +188,19 @@ static ExpressionOperand parseExpressionOperand(
 
 		case TOKEN_STRING_LITERAL:
 		//ensure literal type matches expected type
-		if (expected_type.kind != TYPE_STRUCT && expected_type.kind != TYPE_NONE) {
+		if (expected_kind != TYPE_STRUCT && expected_kind != TYPE_NONE) {
 			printf("ERROR: Mismatched literal type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//fill operand data
+		size_t string_length;
+		const char* string = tokenList_string(&compilation_unit->token_list, currentToken(), &string_length);
 		expression_operand.operand_type = OPERAND_CONSTANT;
-		expression_operand.operand_value.llvm_value.type = (VariableType){.kind=TYPE_STRUCT};
+		expression_operand.operand_value.llvm_value.type_index = TYPE_INDEX_STRING;
 		expression_operand.operand_value.llvm_value.value = LLVMConstStringInContext2(
 			compilation_unit->llvm_context,
-			currentToken().data.string.text,
-			currentToken().data.string.length,
+			string,
+			string_length,
 			true
 		);
 		incrementToken();
@@ -210,13 +212,13 @@ static ExpressionOperand parseExpressionOperand(
 		bool_value = 1;
 		case TOKEN_FALSE:
 		//ensure literal type matches expected type
-		if (expected_type.kind != TYPE_BOOL && expected_type.kind != TYPE_NONE) {
+		if (expected_kind != TYPE_BOOL && expected_kind != TYPE_NONE) {
 			printf("ERROR: Mismatched literal type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
 		//fill operand data
 		expression_operand.operand_type = OPERAND_CONSTANT;
-		expression_operand.operand_value.llvm_value.type = (VariableType){.kind=TYPE_CHAR, .data.width=1};
+		expression_operand.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL_LITERAL;
 		expression_operand.operand_value.llvm_value.value = LLVMConstInt(
 			LLVMInt1TypeInContext(compilation_unit->llvm_context),
 			bool_value,
@@ -231,12 +233,17 @@ static ExpressionOperand parseExpressionOperand(
 	return expression_operand;
 }
 
-static inline bool expressionTypesMismatched(ExpressionOperand left_operand, ExpressionOperand right_operand) {
-	return getOperandValueType(left_operand).kind != getOperandValueType(right_operand).kind &&
-		getOperandValueType(left_operand).kind != TYPE_NONE &&
-		getOperandValueType(right_operand).kind != TYPE_NONE &&
-		!(getOperandValueType(left_operand).kind == TYPE_INT && getOperandValueType(right_operand).kind == TYPE_UNSIGNED) &&
-		!(getOperandValueType(left_operand).kind == TYPE_UNSIGNED && getOperandValueType(right_operand).kind == TYPE_INT);
+static inline bool expressionTypesMismatched(CompilationUnit* compilation_unit, ExpressionOperand left_operand, ExpressionOperand right_operand) {
+	//the same type is the same index, anything else comes down to the kinds
+	if (getOperandTypeIndex(left_operand) == getOperandTypeIndex(right_operand)) return false;
+
+	TypeKind left_kind = getOperandTypeKind(compilation_unit, left_operand);
+	TypeKind right_kind = getOperandTypeKind(compilation_unit, right_operand);
+	return left_kind != right_kind &&
+		left_kind != TYPE_NONE &&
+		right_kind != TYPE_NONE &&
+		!(left_kind == TYPE_INT && right_kind == TYPE_UNSIGNED) &&
+		!(left_kind == TYPE_UNSIGNED && right_kind == TYPE_INT);
 }
 
 //somewhat shabby code, not sure how to improve it though
@@ -258,13 +265,13 @@ static ExpressionOperand emitBinaryOperation(
 			printf("ERROR: Attempted to assign to non-variable operand!\n");
 			exit(1);
 		}
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting assignment!\n");
 			exit(1);
 		}
 		//get assignment value
 		operation_result.operand_value.llvm_value.value = getOperandValue(compilation_unit, llvm_builder, right_operand);
-		operation_result.operand_value.llvm_value.type = left_operand.operand_value.variable->type;
+		operation_result.operand_value.llvm_value.type_index = left_operand.operand_value.variable->type_index;
 		LLVMBuildStore(
 			llvm_builder,
 			operation_result.operand_value.llvm_value.value,
@@ -275,14 +282,14 @@ static ExpressionOperand emitBinaryOperation(
 
 		//arithmetic
 		case TOKEN_PLUS:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting addition!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildAdd(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -291,7 +298,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildFAdd(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -306,14 +313,14 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_MINUS:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting subtraction!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildSub(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -322,7 +329,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildFSub(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -337,14 +344,14 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_STAR:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting multiplication!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildMul(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -353,7 +360,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildFMul(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -368,13 +375,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_FORWARD_SLASH:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting division!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildSDiv(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -383,7 +390,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildUDiv(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -392,7 +399,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildFDiv(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -407,13 +414,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_PERCENT:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting remainder!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildSRem(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -422,7 +429,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildURem(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -431,7 +438,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildFRem(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -447,14 +454,14 @@ static ExpressionOperand emitBinaryOperation(
 
 		//bitwise
 		case TOKEN_AMPERSAND:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting bitwise and!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildAnd(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -469,14 +476,14 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_BAR:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting bitwise or!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildOr(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -491,14 +498,14 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_CARET:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting bitwise xor!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildXor(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -513,14 +520,14 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_LESS_LESS:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting left shift!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildShl(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -535,13 +542,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_GREATER_GREATER:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting left shift!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildAShr(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -550,7 +557,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = getOperandValueType(left_operand);
+			operation_result.operand_value.llvm_value.type_index = getOperandTypeIndex(left_operand);
 			operation_result.operand_value.llvm_value.value = LLVMBuildLShr(
 				llvm_builder,
 				getOperandValue(compilation_unit, llvm_builder, left_operand),
@@ -608,16 +615,16 @@ static ExpressionOperand emitBinaryOperation(
 
 		//comparison
 		case TOKEN_EQUAL_EQUAL:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting equal comparison!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
 			case TYPE_CHAR:
 			case TYPE_BOOL:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntEQ,
@@ -627,7 +634,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildFCmp(
 				llvm_builder,
 				LLVMRealOEQ,
@@ -643,16 +650,16 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_EXCLAMATION_EQUAL:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting not-equal comparison!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
 			case TYPE_UNSIGNED:
 			case TYPE_CHAR:
 			case TYPE_BOOL:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntNE,
@@ -662,7 +669,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildFCmp(
 				llvm_builder,
 				LLVMRealONE,
@@ -678,13 +685,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_LESS:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting less-than comparison!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntSLT,
@@ -694,7 +701,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntULT,
@@ -704,7 +711,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildFCmp(
 				llvm_builder,
 				LLVMRealOLT,
@@ -720,13 +727,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_GREATER:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting greater-than comparison!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntSGT,
@@ -736,7 +743,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntUGT,
@@ -746,7 +753,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildFCmp(
 				llvm_builder,
 				LLVMRealOGT,
@@ -762,13 +769,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_LESS_EQUAL:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting less-than-or-equal comparison!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntSLE,
@@ -778,7 +785,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntULE,
@@ -788,7 +795,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildFCmp(
 				llvm_builder,
 				LLVMRealOLE,
@@ -804,13 +811,13 @@ static ExpressionOperand emitBinaryOperation(
 		break;
 
 		case TOKEN_GREATER_EQUAL:
-		if (expressionTypesMismatched(left_operand, right_operand)) {
+		if (expressionTypesMismatched(compilation_unit, left_operand, right_operand)) {
 			printf("ERROR: Type mismatch when emitting greater-than-or-equal comparison!\n");
 			exit(1);
 		}
-		switch (getOperandValueType(left_operand).kind) {
+		switch (getOperandTypeKind(compilation_unit, left_operand)) {
 			case TYPE_INT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntSGE,
@@ -820,7 +827,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_UNSIGNED:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildICmp(
 				llvm_builder,
 				LLVMIntUGE,
@@ -830,7 +837,7 @@ static ExpressionOperand emitBinaryOperation(
 			);
 			return operation_result;
 			case TYPE_FLOAT:
-			operation_result.operand_value.llvm_value.type = (VariableType){.kind=TYPE_BOOL, .data.width=1};
+			operation_result.operand_value.llvm_value.type_index = TYPE_INDEX_BOOL;
 			operation_result.operand_value.llvm_value.value = LLVMBuildFCmp(
 				llvm_builder,
 				LLVMRealOGE,
@@ -863,18 +870,17 @@ static ExpressionOperand parseExpression(
 	size_t current_scope_index,
 	TokenType expression_terminator,
 	TokenType previous_operator,
-	VariableType expected_type
+	size_t expected_type_index
 ) {
 	ExpressionOperand left_operand = parseExpressionOperand(
 		compilation_unit,
 		current_function,
-		current_scope_index,
-		(VariableType){.kind=TYPE_NONE}
+		TYPE_INDEX_NONE
 	);
 	
-	while (currentToken().type != expression_terminator) {
-		if (currentToken().type == TOKEN_EOF) {UNEXPECTED_TOKEN(currentToken());}
-		TokenType current_operator = currentToken().type;
+	while (currentTokenType() != expression_terminator) {
+		if (currentTokenType() == TOKEN_EOF) {UNEXPECTED_TOKEN(currentToken());}
+		TokenType current_operator = currentTokenType();
 
 		//if the operator precendence has dropped, return early
 		//this results in all previous operators of greater precedence emitting code
@@ -891,7 +897,7 @@ static ExpressionOperand parseExpression(
 			current_scope_index,
 			expression_terminator,
 			current_operator,
-			(VariableType){.kind=TYPE_NONE}
+			TYPE_INDEX_NONE
 		);
 
 		//emit bytecode
@@ -904,7 +910,7 @@ static ExpressionOperand parseExpression(
 		);
 
 		//type checking
-		if (!typesEquivalent(result.operand_value.llvm_value.type, expected_type, false) && expected_type.kind != TYPE_NONE) {
+		if (expected_type_index != TYPE_INDEX_NONE && !typesEquivalent(compilation_unit, result.operand_value.llvm_value.type_index, expected_type_index, false)) {
 			printf("ERROR: Mismatched variable type!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		}
@@ -926,41 +932,45 @@ static void parseVariableDeclaration(
 	ASSERT_NEXT_TOKEN(TOKEN_COLON);
 
 	//create variable in compilation unit
-	Scope* current_scope = current_function->scopes + current_scope_index;
-	Variable* variable = compilationUnit_addScopeVariable(current_scope);
-	variable->identifier_index = compilationUnit_getOrAddIdentifierIndex(compilation_unit, currentToken().data.identifier);
+	Scope* current_scope = compilationUnit_getFunctionScope(current_function, current_scope_index);
+	Variable* variable = compilationUnit_addScopeVariable(compilation_unit, current_scope);
+	variable->identifier_index = currentToken()->payload;
+	//bound straight away so the variable is visible in its own assignment, as it always has been
+	compilationUnit_bindScopeVariable(compilation_unit, current_function, current_scope_index, current_scope->variables.count - 1);
 
 	//get type
 	//assume type is first
 	incrementToken();
 	incrementToken();
-	switch (currentToken().type) {
+	VariableType variable_type;
+	switch (currentTokenType()) {
 		case TOKEN_INTEGER_TYPE:
-		variable->type.kind = TYPE_INT;
-		variable->type.data.width = currentToken().data.type_width;
+		variable_type.kind = TYPE_INT;
+		variable_type.data.width = currentToken()->payload;
 		break;
 		case TOKEN_UNSIGNED_TYPE:
-		variable->type.kind = TYPE_UNSIGNED;
-		variable->type.data.width = currentToken().data.type_width;
+		variable_type.kind = TYPE_UNSIGNED;
+		variable_type.data.width = currentToken()->payload;
 		break;
 		case TOKEN_FLOAT_TYPE:
-		variable->type.kind = TYPE_FLOAT;
-		variable->type.data.width = currentToken().data.type_width;
+		variable_type.kind = TYPE_FLOAT;
+		variable_type.data.width = currentToken()->payload;
 		break;
 		case TOKEN_BOOL_TYPE:
-		variable->type.kind = TYPE_BOOL;
-		variable->type.data.width = 1;
+		variable_type.kind = TYPE_BOOL;
+		variable_type.data.width = 1;
 		break;
 		case TOKEN_CHARACTER_TYPE:
-		variable->type.kind = TYPE_CHAR;
-		variable->type.data.width = 32;
+		variable_type.kind = TYPE_CHAR;
+		variable_type.data.width = 32;
 		break;
 
 		//TODO handle structs
 
 		default: UNEXPECTED_TOKEN(currentToken());
 	}
-	variable->llvm_type = llvmTypeFromVariableType(compilation_unit->llvm_context, variable->type);
+	variable->type_index = compilationUnit_getOrAddTypeIndex(compilation_unit, variable_type);
+	LLVMTypeRef variable_llvm_type = llvmTypeFromTypeIndex(compilation_unit, variable->type_index);
 
 	//emit stack allocation
 	LLVMBuilderRef alloca_builder = LLVMCreateBuilderInContext(compilation_unit->llvm_context);
@@ -972,7 +982,7 @@ static void parseVariableDeclaration(
 	}
 	variable->llvm_stack_pointer = LLVMBuildAlloca(
 		alloca_builder,
-		variable->llvm_type,
+		variable_llvm_type,
 		compilation_unit->identifiers[variable->identifier_index]
 	);
 
@@ -980,7 +990,7 @@ static void parseVariableDeclaration(
 
 	//emit assignment if exists
 	incrementToken();
-	if (currentToken().type == TOKEN_EQUAL) {
+	if (currentTokenType() == TOKEN_EQUAL) {
 		incrementToken();
 		ExpressionOperand assignment_value = parseExpression(
 			compilation_unit,
@@ -989,7 +999,7 @@ static void parseVariableDeclaration(
 			current_scope_index,
 			TOKEN_SEMICOLON,
 			TOKEN_EQUAL,
-			variable->type
+			variable->type_index
 		);
 		emitBinaryOperation(
 			compilation_unit,
@@ -1031,7 +1041,7 @@ static void parseWhileStatement(
 		current_scope_index,
 		TOKEN_BRACE_LEFT,
 		TOKEN_NONE,
-		(VariableType){.kind=TYPE_BOOL, .data.width=1}
+		TYPE_INDEX_BOOL
 	);
 	incrementToken();
 
@@ -1045,7 +1055,7 @@ static void parseWhileStatement(
 	//create and parse new scope
 	Scope* body_scope = compilationUnit_addFunctionScope(compilation_unit, current_function);
 	body_scope->parent_scope_index = current_scope_index;
-	size_t body_scope_index = body_scope - current_function->scopes;
+	size_t body_scope_index = current_function->scopes.count - 1;
 
 	parseScope(compilation_unit, llvm_builder, current_function, body_scope_index);
 
@@ -1108,7 +1118,7 @@ static LLVMBasicBlockRef parseIfStatement(
 		current_scope_index,
 		TOKEN_BRACE_LEFT,
 		TOKEN_NONE,
-		(VariableType){.kind=TYPE_BOOL, .data.width=1}
+		TYPE_INDEX_BOOL
 	);
 	incrementToken();
 
@@ -1122,7 +1132,7 @@ static LLVMBasicBlockRef parseIfStatement(
 	//create and parse new scope
 	Scope* body_scope = compilationUnit_addFunctionScope(compilation_unit, current_function);
 	body_scope->parent_scope_index = current_scope_index;
-	size_t body_scope_index = body_scope - current_function->scopes;
+	size_t body_scope_index = current_function->scopes.count - 1;
 
 	parseScope(compilation_unit, llvm_builder, current_function, body_scope_index);
 
@@ -1131,12 +1141,12 @@ static LLVMBasicBlockRef parseIfStatement(
 
 	//handle else and else ifs
 	LLVMBasicBlockRef else_destination_block = NULL;
-	if (nextToken().type == TOKEN_ELSE) {
+	if (nextTokenType() == TOKEN_ELSE) {
 		incrementToken();
 		incrementToken();
 		
 		//check for else if
-		switch (currentToken().type) {
+		switch (currentTokenType()) {
 			case TOKEN_IF:
 			else_destination_block = parseIfStatement(
 				compilation_unit,
@@ -1160,7 +1170,7 @@ static LLVMBasicBlockRef parseIfStatement(
 			//create and parse new scope
 			Scope* else_body_scope = compilationUnit_addFunctionScope(compilation_unit, current_function);
 			else_body_scope->parent_scope_index = current_scope_index;
-			size_t else_body_scope_index = else_body_scope - current_function->scopes;
+			size_t else_body_scope_index = current_function->scopes.count - 1;
 
 			parseScope(compilation_unit, llvm_builder, current_function, else_body_scope_index);
 
@@ -1195,13 +1205,8 @@ static void parseFunctionBody(CompilationUnit* compilation_unit) {
 	ASSERT_NEXT_TOKEN(TOKEN_IDENTIFIER);
 
 	//get function
-	size_t function_identifier_index = compilationUnit_getOrAddIdentifierIndex(compilation_unit, nextToken().data.identifier);
-	Function* function = NULL;
-	for (size_t i = 0; i < compilation_unit->function_count; ++i) {
-		if (function_identifier_index == compilation_unit->functions[i].identifier_index) {
-			function = compilation_unit->functions + i;
-		}
-	}
+	size_t function_identifier_index = nextToken()->payload;
+	Function* function = compilationUnit_findFunction(compilation_unit, function_identifier_index);
 	if (function == NULL) {
 		printf("ERROR: Function declaration could not be found when parsing definition. This should be impossible!\n");
 		exit(1);
@@ -1219,29 +1224,33 @@ static void parseFunctionBody(CompilationUnit* compilation_unit) {
 	LLVMPositionBuilderAtEnd(llvm_builder, function->llvm_entry_block);
 
 	//setup parameter stack memory
-	for (size_t i = 0; i < function->parameter_count; ++i) {
-		function->parameters[i].llvm_stack_pointer = LLVMBuildAlloca(
+	for (size_t i = 0; i < function->parameters.count; ++i) {
+		Variable* parameter = compilationUnit_getFunctionParameter(function, i);
+		parameter->llvm_stack_pointer = LLVMBuildAlloca(
 			llvm_builder,
-			llvmTypeFromVariableType(compilation_unit->llvm_context, function->parameters[i].type),
-			compilation_unit->identifiers[function->parameters[i].identifier_index]
+			llvmTypeFromTypeIndex(compilation_unit, parameter->type_index),
+			compilation_unit->identifiers[parameter->identifier_index]
 		);
 		LLVMValueRef parameter_llvm_temporary = LLVMGetParam(function->llvm_function, i);
-		LLVMBuildStore(llvm_builder, parameter_llvm_temporary, function->parameters[i].llvm_stack_pointer);
+		LLVMBuildStore(llvm_builder, parameter_llvm_temporary, parameter->llvm_stack_pointer);
 	}
 
-	//create entry scope
-	Scope* entry_scope = compilationUnit_addFunctionScope(compilation_unit, function);
-	size_t entry_scope_index = entry_scope - function->scopes;
+	//make globals and parameters visible to the body
+	compilationUnit_enterFunction(compilation_unit, function);
 
 	//skip declaration
-	while (currentToken().type != TOKEN_BRACE_LEFT) {
-		incrementToken();
-	}
+	skipFunctionDeclaration();
+
+	//create entry scope, with room for every scope nested in the body
+	compilationUnit_reserveFunctionScopes(compilation_unit, function, countFunctionScopes());
+	compilationUnit_addFunctionScope(compilation_unit, function);
+	size_t entry_scope_index = function->scopes.count - 1;
 	incrementToken();
 
 	//parse function body
 	parseScope(compilation_unit, llvm_builder, function, entry_scope_index);
 	incrementToken();
+	compilationUnit_exitScope(compilation_unit);
 
 	//implicit return for void functions and main
 	char* function_identifier = compilation_unit->identifiers[function_identifier_index];
@@ -1251,7 +1260,7 @@ static void parseFunctionBody(CompilationUnit* compilation_unit) {
 		if (strcmp(function_identifier, MAIN_FUNCTION_IDENTIFIER) == 0) {
 			LLVMValueRef llvm_0_int = LLVMConstInt(LLVMInt32TypeInContext(compilation_unit->llvm_context), 0, false);
 			LLVMBuildRet(llvm_builder, llvm_0_int);
-		} else if (function->return_type.kind == TYPE_VOID) {
+		} else if (function->return_type_index == TYPE_INDEX_VOID) {
 			LLVMBuildRetVoid(llvm_builder);
 		} else {
 			printf("ERROR: Non-void function \"%s\" does not return a value!\n", function_identifier);
@@ -1269,9 +1278,9 @@ static bool parseStatement(
 	Function* current_function,
 	size_t scope_index
 ) {
-	switch (currentToken().type) {
+	switch (currentTokenType()) {
 		case TOKEN_IDENTIFIER:
-		if (nextToken().type == TOKEN_COLON) {
+		if (nextTokenType() == TOKEN_COLON) {
 			parseVariableDeclaration(compilation_unit, llvm_builder, current_function, scope_index);
 			incrementToken();
 		} else {
@@ -1282,7 +1291,7 @@ static bool parseStatement(
 				scope_index,
 				TOKEN_SEMICOLON,
 				TOKEN_NONE,
-				(VariableType){.kind=TYPE_NONE, .data={NULL}}
+				TYPE_INDEX_NONE
 			);
 			incrementToken();
 		}
@@ -1302,7 +1311,7 @@ static bool parseStatement(
 		//go down a scope
 		Scope* new_scope = compilationUnit_addFunctionScope(compilation_unit, current_function);
 		new_scope->parent_scope_index = scope_index;
-		size_t new_scope_index = new_scope - current_function->scopes;
+		size_t new_scope_index = current_function->scopes.count - 1;
 		parseScope(compilation_unit, llvm_builder, current_function, new_scope_index);
 		incrementToken();
 		break;
@@ -1325,13 +1334,18 @@ static void parseScope(
 	Function* current_function,
 	size_t scope_index
 ) {
-	while (currentToken().type != TOKEN_EOF) {
-		if (parseStatement(compilation_unit, llvm_builder, current_function, scope_index)) return;
+	Scope* scope = compilationUnit_getFunctionScope(current_function, scope_index);
+	compilationUnit_reserveScopeVariables(compilation_unit, scope, countScopeDeclarations());
+
+	compilationUnit_enterScope(compilation_unit);
+	while (currentTokenType() != TOKEN_EOF) {
+		if (parseStatement(compilation_unit, llvm_builder, current_function, scope_index)) break;
 	}
+	compilationUnit_exitScope(compilation_unit);
 }
 
 static void parseFunctions(CompilationUnit* compilation_unit) {
-	switch (currentToken().type) {
+	switch (currentTokenType()) {
 		case TOKEN_FN:
 		parseFunctionBody(compilation_unit);
 		return;
@@ -1340,14 +1354,25 @@ static void parseFunctions(CompilationUnit* compilation_unit) {
 		skipStruct();
 		return;
 
+		case TOKEN_IMPORT:
+		skipImport();
+		return;
+
 		default: UNEXPECTED_TOKEN(currentToken());
 	}
 }
 
 void parseBlocks(CompilationUnit* compilation_unit) {
-	tokeniserSetSource(compilation_unit->source_file);
+	tokeniserSetTokens(&compilation_unit->token_list);
 
-	while (currentToken().type != TOKEN_EOF) {
+	while (currentTokenType() != TOKEN_EOF) {
 		parseFunctions(compilation_unit);
 	}
 }
+
+void parseFunctionBlock(CompilationUnit* compilation_unit, size_t function_token_index) {
+	tokeniserSetTokens(&compilation_unit->token_list);
+	jumpToToken(function_token_index);
+
+	parseFunctionBody(compilation_unit);
+}
@@ -3,3 +3,5 @@
 #include "compilation_unit.h"
 
 void parseBlocks(CompilationUnit* compilation_unit);
+//parses the body of the one function whose fn keyword is at function_token_index, parseTopLevel must have run
+void parseFunctionBlock(CompilationUnit* compilation_unit, size_t function_token_index);
@@ -2,18 +2,21 @@
 
 #include <llvm-c/Core.h>
 #include <llvm-c/Types.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "compilation_unit.h"
+#include "interface_file.h"
 #include "parser_utils.h"
 #include "token.h"
 #include "tokeniser.h"
 
 //starts on fn keyword
 static void parseFunctionDeclaration(CompilationUnit* compilation_unit) {
-	if (currentToken().type == TOKEN_COMMA) incrementToken();
+	if (currentTokenType() == TOKEN_COMMA) incrementToken();
 
 	ASSERT_CURRENT_TOKEN(TOKEN_FN);
 	ASSERT_NEXT_TOKEN(TOKEN_IDENTIFIER);
@@ -21,37 +24,38 @@ static void parseFunctionDeclaration(CompilationUnit* compilation_unit) {
 
 	//create function and get identifier
 	Function* function = compilationUnit_addFunction(compilation_unit);
-	function->identifier_index = compilationUnit_getOrAddIdentifierIndex(compilation_unit, currentToken().data.identifier);
+	compilationUnit_nameFunction(compilation_unit, function, currentToken()->payload);
 
 	ASSERT_NEXT_TOKEN(TOKEN_PARENTHESIS_LEFT);
 	incrementToken();
+	compilationUnit_reserveFunctionParameters(compilation_unit, function, countParameters());
 	incrementToken();
 	
 	//handle parameters
-	while (currentToken().type != TOKEN_PARENTHESIS_RIGHT) {
-		if (currentToken().type == TOKEN_COMMA) incrementToken();
+	while (currentTokenType() != TOKEN_PARENTHESIS_RIGHT) {
+		if (currentTokenType() == TOKEN_COMMA) incrementToken();
 
 		ASSERT_CURRENT_TOKEN(TOKEN_IDENTIFIER);
 		ASSERT_NEXT_TOKEN(TOKEN_COLON);
 
 		//create parameter and assign identifier
-		Variable* parameter = compilationUnit_addFunctionParameter(function);
-		parameter->identifier_index = compilationUnit_getOrAddIdentifierIndex(compilation_unit, currentToken().data.identifier);
+		Variable* parameter = compilationUnit_addFunctionParameter(compilation_unit, function);
+		parameter->identifier_index = currentToken()->payload;
 		
 		incrementToken();
 		incrementToken();
 
 		//assign parameter type
-		if (currentToken().type == TOKEN_IDENTIFIER) {
+		if (currentTokenType() == TOKEN_IDENTIFIER) {
 			//TODO support structs
 			printf("ERROR: structs not yet supported!\n");
 			UNEXPECTED_TOKEN(currentToken());
 		} else {
-			parameter->type = variableTypeFromToken(currentToken());
+			parameter->type_index = typeIndexFromToken(compilation_unit, currentToken());
 		}
 
 		//TODO handle tags
-		while (currentToken().type != TOKEN_COMMA && currentToken().type != TOKEN_PARENTHESIS_RIGHT) {
+		while (currentTokenType() != TOKEN_COMMA && currentTokenType() != TOKEN_PARENTHESIS_RIGHT) {
 			incrementToken();
 		}
 	}
@@ -60,25 +64,26 @@ static void parseFunctionDeclaration(CompilationUnit* compilation_unit) {
 	//TODO handle tags
 
 	//get return type
-	if (currentToken().type == TOKEN_BRACE_LEFT) {
+	if (currentTokenType() == TOKEN_BRACE_LEFT) {
 		//no return type
-		function->return_type.kind = TYPE_VOID;
-		function->return_type.data.width = 0;
+		function->return_type_index = TYPE_INDEX_VOID;
 
-	} else if (currentToken().type == TOKEN_MINUS_GREATER) {
+	} else if (currentTokenType() == TOKEN_MINUS_GREATER) {
 		//explicit return type
 		//TODO special handling for user defined types
 		incrementToken();
-		switch (currentToken().type) {
-			case TOKEN_INTEGER_TYPE:   function->return_type.kind = TYPE_INT; break;
-			case TOKEN_UNSIGNED_TYPE:  function->return_type.kind = TYPE_UNSIGNED; break;
-			case TOKEN_FLOAT_TYPE:     function->return_type.kind = TYPE_FLOAT; break;
-			case TOKEN_BOOL_TYPE:      function->return_type.kind = TYPE_BOOL; break;
-			case TOKEN_CHARACTER_TYPE: function->return_type.kind = TYPE_CHAR; break;
+		VariableType return_type;
+		switch (currentTokenType()) {
+			case TOKEN_INTEGER_TYPE:   return_type.kind = TYPE_INT; break;
+			case TOKEN_UNSIGNED_TYPE:  return_type.kind = TYPE_UNSIGNED; break;
+			case TOKEN_FLOAT_TYPE:     return_type.kind = TYPE_FLOAT; break;
+			case TOKEN_BOOL_TYPE:      return_type.kind = TYPE_BOOL; break;
+			case TOKEN_CHARACTER_TYPE: return_type.kind = TYPE_CHAR; break;
 
 			default: UNEXPECTED_TOKEN(currentToken());
 		}
-		function->return_type.data.width = currentToken().data.type_width;
+		return_type.data.width = currentToken()->payload;
+		function->return_type_index = compilationUnit_getOrAddTypeIndex(compilation_unit, return_type);
 		incrementToken();
 
 	} else {
@@ -100,25 +105,51 @@ static void parseFunctionDeclaration(CompilationUnit* compilation_unit) {
 }
 
 static void parseNonStructs(CompilationUnit* compilation_unit) {
-	switch (currentToken().type) {
+	switch (currentTokenType()) {
 		case TOKEN_FN:
 		parseFunctionDeclaration(compilation_unit);
 		return;
 
 		case TOKEN_STRUCT:
-		//skip declaration
-		while (currentToken().type != TOKEN_BRACE_LEFT) {
-			incrementToken();
-		}
-		//skip definition
-		skipScope();
-		incrementToken();
+		skipStruct();
+		return;
+
+		case TOKEN_IMPORT:
+		skipImport();
 		return;
 
 		default: UNEXPECTED_TOKEN(currentToken());
 	}
 }
 
+//starts on import keyword, ends after the semicolon
+//the string is the path of the imported source relative to this one, its interface file is read instead of the source
+static void parseImport(CompilationUnit* compilation_unit) {
+	ASSERT_CURRENT_TOKEN(TOKEN_IMPORT);
+	ASSERT_NEXT_TOKEN(TOKEN_STRING_LITERAL);
+	incrementToken();
+
+	const TokenList* token_list = currentTokenList();
+	TokenString import_string = token_list->strings[currentToken()->payload];
+	const char* import_path = token_list->string_data + import_string.offset;
+
+	//relative paths start from the directory of the importing source, standard input is taken to be in the working directory
+	const char* source_path = compilation_unit->source_path;
+	const char* last_slash = strrchr(source_path, '/');
+	bool absolute = import_string.length > 0 && import_path[0] == '/';
+	size_t directory_length = !absolute && last_slash != NULL ? (size_t)(last_slash - source_path) + 1 : 0;
+
+	char interface_path[directory_length + import_string.length + sizeof(INTERFACE_FILE_EXTENSION)];
+	memcpy(interface_path, source_path, directory_length);
+	memcpy(interface_path + directory_length, import_path, import_string.length);
+	strcpy(interface_path + directory_length + import_string.length, INTERFACE_FILE_EXTENSION);
+	compilationUnit_addImport(compilation_unit, interfaceFile_open(interface_path));
+
+	ASSERT_NEXT_TOKEN(TOKEN_SEMICOLON);
+	incrementToken();
+	incrementToken();
+}
+
 //starts on struct keyword
 static void parseStructDefinition(CompilationUnit* compilation_unit) {
 	(void)compilation_unit;
@@ -131,19 +162,18 @@ static void parseStructDefinition(CompilationUnit* compilation_unit) {
 }
 
 static void parseStructs(CompilationUnit* compilation_unit) {
-	switch (currentToken().type) {
+	switch (currentTokenType()) {
 		case TOKEN_STRUCT:
 		parseStructDefinition(compilation_unit);
 		return;
 
 		case TOKEN_FN:
-		//skip declaration
-		while (currentToken().type != TOKEN_BRACE_LEFT) {
-			incrementToken();
-		}
-		//skip definition
-		skipScope();
-		incrementToken();
+		skipFunction();
+		return;
+
+		//imports are opened in the first pass, nothing is read from them until a name is looked up
+		case TOKEN_IMPORT:
+		parseImport(compilation_unit);
 		return;
 
 		default: UNEXPECTED_TOKEN(currentToken());
@@ -151,16 +181,16 @@ static void parseStructs(CompilationUnit* compilation_unit) {
 }
 
 void parseTopLevel(CompilationUnit* compilation_unit) {
-	tokeniserSetSource(compilation_unit->source_file);
+	tokeniserSetTokens(&compilation_unit->token_list);
 
 	//parse structs first since they can be included as return types and static variable values
-	while (currentToken().type != TOKEN_EOF) {
+	while (currentTokenType() != TOKEN_EOF) {
 		parseStructs(compilation_unit);
 	}
 
-	tokeniserSetSource(compilation_unit->source_file); //reset for next run
+	tokeniserSetTokens(&compilation_unit->token_list); //reset for next run
 
-	while (currentToken().type != TOKEN_EOF) {
+	while (currentTokenType() != TOKEN_EOF) {
 		parseNonStructs(compilation_unit);
 	}
 }
@@ -14,36 +14,22 @@
 
 //starts on opening brace, ends on closing brace
 void skipScope(void) {
-	if (currentToken().type != TOKEN_BRACE_LEFT) {
+	if (currentTokenType() != TOKEN_BRACE_LEFT) {
 		UNEXPECTED_TOKEN(currentToken());
 	}
-	incrementToken();
-
-	size_t depth = 0;
-	while (currentToken().type != TOKEN_EOF) {
-		switch (currentToken().type) {
-			case TOKEN_BRACE_LEFT:
-			++depth;
-			break;
 
-			case TOKEN_BRACE_RIGHT:
-			if (depth <= 0) return;
-			--depth;
-			break;
-
-			default: break;
-		}
-
-		incrementToken();
+	//the tokeniser matched every brace up front
+	uint32_t closing_index = currentToken()->payload;
+	if (closing_index == TOKEN_NO_MATCH) {
+		printf("ERROR: Hit EOF while skipping over scope! Ensure all scopes are properly closed!\n");
+		exit(1);
 	}
-
-	printf("ERROR: Hit EOF while skipping over scope! Ensure all scopes are properly closed!\n");
-	exit(1);
+	jumpToToken(closing_index);
 }
 
 void skipStruct(void) {
 	//skip declaration
-	while (currentToken().type != TOKEN_BRACE_LEFT) {
+	while (currentTokenType() != TOKEN_BRACE_LEFT) {
 		incrementToken();
 	}
 	//skip definition
@@ -52,23 +38,105 @@ void skipStruct(void) {
 	return;
 }
 
-VariableType variableTypeFromToken(Token token) {
+//starts on fn keyword, ends on the opening brace of the body
+void skipFunctionDeclaration(void) {
+	while (currentTokenType() != TOKEN_BRACE_LEFT) {
+		//jump over parameter lists whole
+		if (currentTokenType() == TOKEN_PARENTHESIS_LEFT && currentToken()->payload != TOKEN_NO_MATCH) {
+			jumpToToken(currentToken()->payload);
+		}
+		incrementToken();
+	}
+}
+
+//starts on fn keyword, ends after the closing brace of the body
+void skipFunction(void) {
+	skipFunctionDeclaration();
+	//skip definition
+	skipScope();
+	incrementToken();
+}
+
+//starts on import keyword, ends after the semicolon
+void skipImport(void) {
+	ASSERT_CURRENT_TOKEN(TOKEN_IMPORT);
+	ASSERT_NEXT_TOKEN(TOKEN_STRING_LITERAL);
+	incrementToken();
+	ASSERT_NEXT_TOKEN(TOKEN_SEMICOLON);
+	incrementToken();
+	incrementToken();
+}
+
+//each parameter has one colon between its name and type
+size_t countParameters(void) {
+	const Token* tokens = currentTokenList()->tokens;
+	size_t start = currentTokenIndex();
+	if (tokens[start].payload == TOKEN_NO_MATCH) return 0;
+
+	size_t parameter_count = 0;
+	for (size_t i = start + 1; i < tokens[start].payload; ++i) {
+		if (tokens[i].type == TOKEN_COLON) ++parameter_count;
+	}
+	return parameter_count;
+}
+
+//every opening brace in a body starts a scope
+size_t countFunctionScopes(void) {
+	const Token* tokens = currentTokenList()->tokens;
+	size_t start = currentTokenIndex();
+	if (tokens[start].payload == TOKEN_NO_MATCH) return 1;
+
+	size_t scope_count = 0;
+	for (size_t i = start; i < tokens[start].payload; ++i) {
+		if (tokens[i].type == TOKEN_BRACE_LEFT) ++scope_count;
+	}
+	return scope_count;
+}
+
+//a declaration is an identifier followed by a colon at the start of a statement
+size_t countScopeDeclarations(void) {
+	const TokenList* token_list = currentTokenList();
+	const Token* tokens = token_list->tokens;
+
+	size_t declaration_count = 0;
+	//the list always ends with TOKEN_EOF so i + 1 is in range
+	for (size_t i = currentTokenIndex(); tokens[i].type != TOKEN_EOF; ++i) {
+		switch (tokens[i].type) {
+			case TOKEN_BRACE_RIGHT: return declaration_count;
+
+			case TOKEN_BRACE_LEFT:
+			//jump nested scopes whole
+			if (tokens[i].payload == TOKEN_NO_MATCH) return declaration_count;
+			i = tokens[i].payload;
+			break;
+
+			case TOKEN_IDENTIFIER:
+			if (tokens[i + 1].type == TOKEN_COLON) ++declaration_count;
+			break;
+
+			default: break;
+		}
+	}
+	return declaration_count;
+}
+
+size_t typeIndexFromToken(CompilationUnit* compilation_unit, const Token* token) {
 	VariableType variable_type;
 
-	switch (token.type) {
+	switch (token->type) {
 		case TOKEN_INTEGER_TYPE:
 		variable_type.kind = TYPE_INT;
-		variable_type.data.width = token.data.type_width;
+		variable_type.data.width = token->payload;
 		break;
 
 		case TOKEN_UNSIGNED_TYPE:
 		variable_type.kind = TYPE_UNSIGNED;
-		variable_type.data.width = token.data.type_width;
+		variable_type.data.width = token->payload;
 		break;
 
 		case TOKEN_FLOAT_TYPE:
 		variable_type.kind = TYPE_FLOAT;
-		variable_type.data.width = token.data.type_width;
+		variable_type.data.width = token->payload;
 		//ensure valid bit width
 		switch (variable_type.data.width) {
 			case 16:
@@ -96,10 +164,10 @@ VariableType variableTypeFromToken(Token token) {
 		default: UNEXPECTED_TOKEN(token);
 	}
 
-	return variable_type;
+	return compilationUnit_getOrAddTypeIndex(compilation_unit, variable_type);
 }
 
-LLVMTypeRef llvmTypeFromVariableType(LLVMContextRef llvm_context, VariableType variable_type) {
+static LLVMTypeRef llvmTypeFromVariableType(LLVMContextRef llvm_context, VariableType variable_type) {
 	size_t type_width = variable_type.data.width == 0 ? TARGET_WORD_SIZE : variable_type.data.width;
 
 	switch (variable_type.kind) {
@@ -139,10 +207,16 @@ LLVMTypeRef llvmTypeFromVariableType(LLVMContextRef llvm_context, VariableType v
 	}
 }
 
+LLVMTypeRef llvmTypeFromTypeIndex(CompilationUnit* compilation_unit, size_t type_index) {
+	InternedType* type = compilation_unit->types + type_index;
+	if (type->llvm_type == NULL) type->llvm_type = llvmTypeFromVariableType(compilation_unit->llvm_context, type->type);
+	return type->llvm_type;
+}
+
 LLVMTypeRef llvmFunctionTypeFromFunction(CompilationUnit* compilation_unit, Function* function) {
-	LLVMTypeRef parameters[function->parameter_count];
-	for (size_t i = 0; i < function->parameter_count; ++i) {
-		parameters[i] = llvmTypeFromVariableType(compilation_unit->llvm_context, function->parameters[i].type);
+	LLVMTypeRef parameters[function->parameters.count];
+	for (size_t i = 0; i < function->parameters.count; ++i) {
+		parameters[i] = llvmTypeFromTypeIndex(compilation_unit, compilationUnit_getFunctionParameter(function, i)->type_index);
 	}
 
 	//if function is main, hardcode return type to work with libc
@@ -152,13 +226,13 @@ LLVMTypeRef llvmFunctionTypeFromFunction(CompilationUnit* compilation_unit, Func
 	if (strcmp(function_identifier, MAIN_FUNCTION_IDENTIFIER) == 0) {
 		return_type = LLVMInt32TypeInContext(compilation_unit->llvm_context);
 	} else {
-		return_type = llvmTypeFromVariableType(compilation_unit->llvm_context, function->return_type);
+		return_type = llvmTypeFromTypeIndex(compilation_unit, function->return_type_index);
 	}
 
 	return LLVMFunctionType(
 		return_type,
 		parameters,
-		function->parameter_count,
+		function->parameters.count,
 		false
 	);
 }
@@ -209,14 +283,17 @@ size_t operatorPrecedence(TokenType operator_type) {
 	}
 }
 
-bool typesEquivalent(VariableType t0, VariableType t1, bool check_width) {
+bool typesEquivalent(const CompilationUnit* compilation_unit, size_t type_index0, size_t type_index1, bool check_width) {
+	//interned types are only equal if their indexes are
+	if (type_index0 == type_index1) return true;
+	if (check_width) return false;
+
+	VariableType t0 = compilation_unit->types[type_index0].type;
+	VariableType t1 = compilation_unit->types[type_index1].type;
 	if (t0.kind != t1.kind) return false;
 
-	if (t0.kind == TYPE_STRUCT) {
-		if (t0.data.struct_type != t1.data.struct_type) return false;
-	} else {
-		if (t0.data.width != t1.data.width && check_width) return false;
-	}
+	//widths are not checked so only the struct type of structs can still differ
+	if (t0.kind == TYPE_STRUCT) return t0.data.struct_type == t1.data.struct_type;
 
 	return true;
 }
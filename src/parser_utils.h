@@ -2,6 +2,7 @@
 
 #include "compilation_unit.h"
 #include "token.h"
+#include "tokeniser.h"
 
 //assume compiler of compiler is the one using the compiler
 #define TARGET_WORD_SIZE (sizeof(size_t) * 8)
@@ -9,24 +10,38 @@
 
 #define UNEXPECTED_TOKEN(TOKEN)                                                                         \
 printf("ERROR: Unexpected token ");                                                                     \
-printToken(TOKEN);                                                                                      \
+printToken(currentTokenList(), TOKEN);                                                                  \
 printf("\nError called from:\n\tFile: %s\n\tFunction: %s\n\tLine: %d\n", __FILE__, __func__, __LINE__); \
 exit(1)
 
 #define ASSERT_CURRENT_TOKEN(TOKEN_TYPE) \
-if (currentToken().type != TOKEN_TYPE) {UNEXPECTED_TOKEN(currentToken());}
+if (currentTokenType() != TOKEN_TYPE) {UNEXPECTED_TOKEN(currentToken());}
 
 #define ASSERT_NEXT_TOKEN(TOKEN_TYPE) \
-if (nextToken().type != TOKEN_TYPE) {UNEXPECTED_TOKEN(nextToken());}
+if (nextTokenType() != TOKEN_TYPE) {UNEXPECTED_TOKEN(nextToken());}
 
+//all jump straight over bodies using the delimiter matches from the tokeniser
 void skipScope(void);
 void skipStruct(void);
-
-VariableType variableTypeFromToken(Token token);
-
-LLVMTypeRef llvmTypeFromVariableType(LLVMContextRef llvm_context, VariableType variable_type);
+void skipFunctionDeclaration(void);
+void skipFunction(void);
+void skipImport(void);
+
+//counts so lists can be sized before they are filled, none of them move the current token
+//starts on the opening parenthesis of a parameter list
+size_t countParameters(void);
+//starts on the opening brace of a function body, includes the body itself
+size_t countFunctionScopes(void);
+//starts on the first token inside a scope, only counts declarations in that scope and not in ones nested in it
+size_t countScopeDeclarations(void);
+
+//interned in compilation_unit
+size_t typeIndexFromToken(CompilationUnit* compilation_unit, const Token* token);
+
+//each type's llvm type is only built once, later calls return the cached one
+LLVMTypeRef llvmTypeFromTypeIndex(CompilationUnit* compilation_unit, size_t type_index);
 LLVMTypeRef llvmFunctionTypeFromFunction(CompilationUnit* compilation_unit, Function* function);
 
 size_t operatorPrecedence(TokenType operator_type);
 
-bool typesEquivalent(VariableType t0, VariableType t1, bool check_width);
+bool typesEquivalent(const CompilationUnit* compilation_unit, size_t type_index0, size_t type_index1, bool check_width);
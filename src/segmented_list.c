@@ -0,0 +1,39 @@
+#include "segmented_list.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static void addSegment(SegmentedList* list, Arena* arena, size_t element_size, size_t alignment) {
+	size_t segment_length = ((size_t)1 << list->first_segment_shift) << list->segment_count;
+	list->segments = arena_reallocate(arena, list->segments, list->segment_count * sizeof(void*), (list->segment_count + 1) * sizeof(void*), _Alignof(void*));
+	list->segments[list->segment_count] = arena_allocate(arena, segment_length * element_size, alignment);
+	++list->segment_count;
+}
+
+void* segmentedList_add(SegmentedList* list, Arena* arena, size_t element_size, size_t alignment) {
+	if (list->count == segmentedList_capacity(list)) {
+		if (list->segment_count == 0) list->first_segment_shift = SEGMENTED_LIST_FIRST_SEGMENT_SHIFT;
+		addSegment(list, arena, element_size, alignment);
+	}
+
+	void* element = segmentedList_get(list, list->count, element_size);
+	memset(element, 0, element_size);
+	++list->count;
+	return element;
+}
+
+void segmentedList_reserve(SegmentedList* list, Arena* arena, size_t count, size_t element_size, size_t alignment) {
+	if (list->segment_count == 0 && count > 0) {
+		list->first_segment_shift = 0;
+		while (((size_t)1 << list->first_segment_shift) < count) ++list->first_segment_shift;
+	}
+	while (segmentedList_capacity(list) < count) addSegment(list, arena, element_size, alignment);
+}
+
+size_t segmentedList_capacity(const SegmentedList* list) {
+	if (list->segment_count == 0) return 0;
+
+	//each segment holds as many as all the ones before it plus one first segment
+	size_t first_segment_length = (size_t)1 << list->first_segment_shift;
+	return (first_segment_length << list->segment_count) - first_segment_length;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+//list whose elements never move once added, so pointers to them stay valid however much it grows
+//segment i holds twice what segment i - 1 does, growing adds a segment and copies no elements
+//only the small table of segment pointers is ever reallocated, and the arena keeps the old table readable until it is reset
+//a list that is all zero is empty and ready to use
+
+//first segment holds 1 << SEGMENTED_LIST_FIRST_SEGMENT_SHIFT elements unless the list was reserved before it was added to
+#define SEGMENTED_LIST_FIRST_SEGMENT_SHIFT 2
+
+typedef struct {
+	void** segments;
+	//never more than the bits in a size_t, kept small so the list is no bigger than a pointer and two sizes
+	uint32_t segment_count;
+	uint32_t first_segment_shift; //set when the first segment is allocated
+	size_t count;
+} SegmentedList;
+
+//new element is zeroed, never returns NULL
+void* segmentedList_add(SegmentedList* list, Arena* arena, size_t element_size, size_t alignment);
+
+//makes room for count elements, a list with no segments yet gets a first segment big enough for all of them
+//so a list whose final size is known up front lives in one segment
+void segmentedList_reserve(SegmentedList* list, Arena* arena, size_t count, size_t element_size, size_t alignment);
+
+//elements the segments so far can hold
+size_t segmentedList_capacity(const SegmentedList* list);
+
+//index must be less than count
+static inline void* segmentedList_get(const SegmentedList* list, size_t index, size_t element_size) {
+	//index plus one first segment, counted in first segments, has its top bit at the segment number
+	size_t first_segment_length = (size_t)1 << list->first_segment_shift;
+	size_t shifted_index = (index >> list->first_segment_shift) + 1;
+	size_t segment = (sizeof(unsigned long long) * 8 - 1) - __builtin_clzll(shifted_index);
+	size_t offset = index + first_segment_length - (first_segment_length << segment);
+	return (char*)list->segments[segment] + offset * element_size;
+}
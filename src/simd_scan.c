@@ -0,0 +1,276 @@
+#include "simd_scan.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_SCAN_X86
+#include <immintrin.h>
+#endif
+
+/*
+
+scalar fallbacks
+
+*/
+
+static inline bool isWhitespace(char c) {
+	return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+static inline bool isIdentifierCharacter(char c) {
+	return (unsigned char)((c | 0x20) - 'a') <= 'z' - 'a' || (unsigned char)(c - '0') <= 9 || c == '_';
+}
+
+static const char* skipWhitespaceScalar(const char* position) {
+	while (isWhitespace(*position)) {
+		++position;
+	}
+	return position;
+}
+
+static const char* findIdentifierEndScalar(const char* position) {
+	while (isIdentifierCharacter(*position)) {
+		++position;
+	}
+	return position;
+}
+
+static const char* findStringSpecialScalar(const char* position) {
+	while (*position != '"' && *position != '\\' && *position != '\0') {
+		++position;
+	}
+	return position;
+}
+
+//keeps the same 32 free slot contract as the vector kernels
+static const char* findLineStartsScalar(const char* source, const char* position, const char* end, uint32_t* line_starts, size_t* line_count, size_t line_capacity) {
+	size_t count = *line_count;
+	while (position < end && line_capacity - count >= 32) {
+		if (*position == '\n') {
+			line_starts[count] = position - source + 1;
+			++count;
+		}
+		++position;
+	}
+	*line_count = count;
+	return position;
+}
+
+/*
+
+x86 kernels
+
+*/
+
+#ifdef SIMD_SCAN_X86
+
+//appends the line start after every newline set in newline_mask
+static inline size_t appendLineStarts(uint32_t newline_mask, size_t block_offset, uint32_t* line_starts, size_t count) {
+	while (newline_mask != 0) {
+		line_starts[count] = block_offset + __builtin_ctz(newline_mask) + 1;
+		++count;
+		newline_mask &= newline_mask - 1;
+	}
+	return count;
+}
+
+//lanes where LOW <= c <= HIGH, done with one signed compare by biasing LOW down to -128
+#define SSE2_IN_RANGE(BLOCK, LOW, HIGH) _mm_cmpgt_epi8(                   \
+	_mm_set1_epi8((char)(0x80 + ((HIGH) - (LOW) + 1))),                   \
+	_mm_add_epi8(BLOCK, _mm_set1_epi8((char)(0x80 - (LOW))))              \
+)
+#define AVX2_IN_RANGE(BLOCK, LOW, HIGH) _mm256_cmpgt_epi8(                \
+	_mm256_set1_epi8((char)(0x80 + ((HIGH) - (LOW) + 1))),                \
+	_mm256_add_epi8(BLOCK, _mm256_set1_epi8((char)(0x80 - (LOW))))        \
+)
+
+//sse2 is part of x86_64 so these only need a cpu check on 32 bit x86
+
+__attribute__((target("sse2")))
+static const char* skipWhitespaceSse2(const char* position) {
+	while (true) {
+		__m128i block = _mm_loadu_si128((const __m128i*)position);
+		__m128i whitespace = _mm_or_si128(
+			_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+			SSE2_IN_RANGE(block, '\t', '\r')
+		);
+		uint32_t whitespace_mask = _mm_movemask_epi8(whitespace);
+
+		if (whitespace_mask != 0xFFFF) return position + __builtin_ctz(~whitespace_mask);
+		position += 16;
+	}
+}
+
+__attribute__((target("sse2")))
+static const char* findIdentifierEndSse2(const char* position) {
+	while (true) {
+		__m128i block = _mm_loadu_si128((const __m128i*)position);
+		__m128i identifier = _mm_or_si128(
+			_mm_or_si128(
+				SSE2_IN_RANGE(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 'z'),
+				SSE2_IN_RANGE(block, '0', '9')
+			),
+			_mm_cmpeq_epi8(block, _mm_set1_epi8('_'))
+		);
+		uint32_t identifier_mask = _mm_movemask_epi8(identifier);
+
+		if (identifier_mask != 0xFFFF) return position + __builtin_ctz(~identifier_mask);
+		position += 16;
+	}
+}
+
+__attribute__((target("sse2")))
+static const char* findStringSpecialSse2(const char* position) {
+	while (true) {
+		__m128i block = _mm_loadu_si128((const __m128i*)position);
+		__m128i special = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+				_mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))
+			),
+			_mm_cmpeq_epi8(block, _mm_setzero_si128())
+		);
+		uint32_t special_mask = _mm_movemask_epi8(special);
+
+		if (special_mask != 0) return position + __builtin_ctz(special_mask);
+		position += 16;
+	}
+}
+
+__attribute__((target("avx2")))
+static const char* skipWhitespaceAvx2(const char* position) {
+	while (true) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)position);
+		__m256i whitespace = _mm256_or_si256(
+			_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+			AVX2_IN_RANGE(block, '\t', '\r')
+		);
+		uint32_t whitespace_mask = _mm256_movemask_epi8(whitespace);
+
+		if (whitespace_mask != 0xFFFFFFFF) return position + __builtin_ctz(~whitespace_mask);
+		position += 32;
+	}
+}
+
+__attribute__((target("avx2")))
+static const char* findIdentifierEndAvx2(const char* position) {
+	while (true) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)position);
+		__m256i identifier = _mm256_or_si256(
+			_mm256_or_si256(
+				AVX2_IN_RANGE(_mm256_or_si256(block, _mm256_set1_epi8(0x20)), 'a', 'z'),
+				AVX2_IN_RANGE(block, '0', '9')
+			),
+			_mm256_cmpeq_epi8(block, _mm256_set1_epi8('_'))
+		);
+		uint32_t identifier_mask = _mm256_movemask_epi8(identifier);
+
+		if (identifier_mask != 0xFFFFFFFF) return position + __builtin_ctz(~identifier_mask);
+		position += 32;
+	}
+}
+
+__attribute__((target("avx2")))
+static const char* findStringSpecialAvx2(const char* position) {
+	while (true) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)position);
+		__m256i special = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')),
+				_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'))
+			),
+			_mm256_cmpeq_epi8(block, _mm256_setzero_si256())
+		);
+		uint32_t special_mask = _mm256_movemask_epi8(special);
+
+		if (special_mask != 0) return position + __builtin_ctz(special_mask);
+		position += 32;
+	}
+}
+
+__attribute__((target("sse2")))
+static const char* findLineStartsSse2(const char* source, const char* position, const char* end, uint32_t* line_starts, size_t* line_count, size_t line_capacity) {
+	size_t count = *line_count;
+	while (position < end && line_capacity - count >= 32) {
+		__m128i block = _mm_loadu_si128((const __m128i*)position);
+		uint32_t newline_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+		//ignore anything past end, which may not be padding
+		if (end - position < 16) newline_mask &= (1u << (end - position)) - 1;
+
+		count = appendLineStarts(newline_mask, position - source, line_starts, count);
+		position += 16;
+	}
+	*line_count = count;
+	return position < end ? position : end;
+}
+
+__attribute__((target("avx2")))
+static const char* findLineStartsAvx2(const char* source, const char* position, const char* end, uint32_t* line_starts, size_t* line_count, size_t line_capacity) {
+	size_t count = *line_count;
+	while (position < end && line_capacity - count >= 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)position);
+		uint32_t newline_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+		//ignore anything past end, which may not be padding
+		if (end - position < 32) newline_mask &= (1u << (end - position)) - 1;
+
+		count = appendLineStarts(newline_mask, position - source, line_starts, count);
+		position += 32;
+	}
+	*line_count = count;
+	return position < end ? position : end;
+}
+
+#endif
+
+/*
+
+dispatch
+
+*/
+
+static const char* (*skip_whitespace)(const char*) = skipWhitespaceScalar;
+static const char* (*find_identifier_end)(const char*) = findIdentifierEndScalar;
+static const char* (*find_string_special)(const char*) = findStringSpecialScalar;
+static const char* (*find_line_starts)(const char*, const char*, const char*, uint32_t*, size_t*, size_t) = findLineStartsScalar;
+
+void simdScan_init(void) {
+#ifdef SIMD_SCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		skip_whitespace = skipWhitespaceAvx2;
+		find_identifier_end = findIdentifierEndAvx2;
+		find_string_special = findStringSpecialAvx2;
+		find_line_starts = findLineStartsAvx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		skip_whitespace = skipWhitespaceSse2;
+		find_identifier_end = findIdentifierEndSse2;
+		find_string_special = findStringSpecialSse2;
+		find_line_starts = findLineStartsSse2;
+	}
+#endif
+}
+
+const char* simdScan_skipWhitespace(const char* position) {
+	return skip_whitespace(position);
+}
+
+const char* simdScan_findIdentifierEnd(const char* position) {
+	return find_identifier_end(position);
+}
+
+const char* simdScan_findStringSpecial(const char* position) {
+	return find_string_special(position);
+}
+
+const char* simdScan_findLineStarts(
+	const char* source,
+	const char* position,
+	const char* end,
+	uint32_t* line_starts,
+	size_t* line_count,
+	size_t line_capacity
+) {
+	return find_line_starts(source, position, end, line_starts, line_count, line_capacity);
+}
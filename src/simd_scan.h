@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//vectorised scanning kernels used by the tokeniser
+//all of them may read up to 32 bytes past the position they stop at,
+//so the scanned buffer must be followed by SOURCE_PADDING zero bytes (see compilation_unit.h)
+//'\0' stops every kernel
+
+//picks the widest kernels the cpu supports, must be called before the functions below
+void simdScan_init(void);
+
+//returns first non whitespace character at or after position
+const char* simdScan_skipWhitespace(const char* position);
+//returns first character at or after position that is not a letter, digit or underscore
+const char* simdScan_findIdentifierEnd(const char* position);
+//returns first '"', '\\' or '\0' at or after position
+const char* simdScan_findStringSpecial(const char* position);
+
+//appends the offset from source of the character after each newline in [position, end) to line_starts
+//returns where it stopped, which is before end if fewer than 32 free slots remain in line_starts
+const char* simdScan_findLineStarts(
+	const char* source,
+	const char* position,
+	const char* end,
+	uint32_t* line_starts,
+	size_t* line_count,
+	size_t line_capacity
+);
@@ -1,6 +1,10 @@
 #include "token.h"
 
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 const char* tokenTypeToString(TokenType type) {
 	switch (type) {
@@ -11,6 +15,7 @@ const char* tokenTypeToString(TokenType type) {
 
 		case TOKEN_FN: return "TOKEN_FN";
 		case TOKEN_STRUCT: return "TOKEN_STRUCT";
+		case TOKEN_IMPORT: return "TOKEN_IMPORT";
 
 		case TOKEN_IF: return "TOKEN_IF";
 		case TOKEN_ELSE: return "TOKEN_ELSE";
@@ -78,29 +83,100 @@ const char* tokenTypeToString(TokenType type) {
 	}
 }
 
-void printToken(Token token) {
-	printf("{%s, index: %zu, length: %zu, line: %zu, column: %zu",
-			tokenTypeToString(token.type), token.offset_in_source, token.length_in_source, token.line_number, token.column_number);
+void printToken(const TokenList* token_list, const Token* token) {
+	size_t length = tokenList_tokenLength(token_list, token);
+	size_t line, column;
+	tokenList_lineAndColumn(token_list, token->offset_in_source, &line, &column);
+
+	//streamed sources are not kept, so the text and its length are unknown
+	if (token_list->source == NULL) {
+		printf("{%s, index: %" PRIu32 ", line: %zu, column: %zu",
+				tokenTypeToString(token->type), token->offset_in_source, line, column);
+	} else {
+		printf("{%s, index: %" PRIu32 ", length: %zu, line: %zu, column: %zu",
+				tokenTypeToString(token->type), token->offset_in_source, length, line, column);
+	}
 	
-	switch (token.type) {
+	switch (token->type) {
 		case TOKEN_IDENTIFIER:;
-		printf(", identifier: %s}", token.data.identifier);
+		if (token_list->source == NULL) {
+			printf("}");
+			break;
+		}
+		printf(", identifier: %.*s}", (int)length, token_list->source + token->offset_in_source);
 		break;
 
 		case TOKEN_INTEGER_TYPE:
 		case TOKEN_UNSIGNED_TYPE:
 		case TOKEN_FLOAT_TYPE:
-		printf(", width: %zu}", token.data.type_width);
+		printf(", width: %" PRIu32 "}", token->payload);
 		break;
 
-		case TOKEN_INTEGER_LITERAL: printf(", data: %zu}", token.data.integer); break;
-		case TOKEN_REAL_LITERAL: printf(", data: %f}", token.data.real); break;
-		case TOKEN_CHARACTER_LITERAL: printf(", data: %c}", token.data.character); break;
-		case TOKEN_STRING_LITERAL: printf(", data: %.*s}", (int)token.data.string.length, token.data.string.text); break;
+		case TOKEN_INTEGER_LITERAL: printf(", data: %" PRIu64 "}", tokenList_integer(token_list, token)); break;
+		case TOKEN_REAL_LITERAL: printf(", data: %f}", tokenList_real(token_list, token)); break;
+		case TOKEN_CHARACTER_LITERAL: printf(", data: %c}", (char)token->payload); break;
+		case TOKEN_STRING_LITERAL:;
+		size_t string_length;
+		const char* string = tokenList_string(token_list, token, &string_length);
+		printf(", data: %.*s}", (int)string_length, string);
+		break;
 
 		default: printf("}"); break;
+	}
+}
 
-		//need to add null termination for printf
-		
+void tokenList_destroy(TokenList* token_list) {
+	free(token_list->tokens);
+	free(token_list->integers);
+	free(token_list->reals);
+	free(token_list->strings);
+	free(token_list->string_data);
+	free(token_list->line_starts);
+	memset(token_list, 0, sizeof(*token_list));
+}
+
+uint64_t tokenList_integer(const TokenList* token_list, const Token* token) {
+	return token_list->integers[token->payload];
+}
+
+double tokenList_real(const TokenList* token_list, const Token* token) {
+	return token_list->reals[token->payload];
+}
+
+const char* tokenList_string(const TokenList* token_list, const Token* token, size_t* length) {
+	TokenString string = token_list->strings[token->payload];
+	*length = string.length;
+	return token_list->string_data + string.offset;
+}
+
+//only whitespace can separate tokens, so a token ends at the last non whitespace character before the next one
+size_t tokenList_tokenLength(const TokenList* token_list, const Token* token) {
+	if (token->type == TOKEN_EOF || token_list->source == NULL) return 0;
+
+	const Token* next_token = token + 1;
+	size_t end = next_token->offset_in_source;
+	while (end > token->offset_in_source + 1) {
+		char c = token_list->source[end - 1];
+		if (c != ' ' && (c < '\t' || c > '\r')) break;
+		--end;
 	}
+	return end - token->offset_in_source;
+}
+
+//columns count characters from 1 at the start of each line
+void tokenList_lineAndColumn(const TokenList* token_list, size_t offset_in_source, size_t* line, size_t* column) {
+	//find the last line starting at or before offset_in_source
+	size_t low = 0;
+	size_t high = token_list->line_count;
+	while (high - low > 1) {
+		size_t middle = low + (high - low) / 2;
+		if (token_list->line_starts[middle] <= offset_in_source) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+
+	*line = low + 1;
+	*column = offset_in_source - token_list->line_starts[low] + 1;
 }
@@ -13,6 +13,7 @@ typedef enum {
 	//keywords
 	TOKEN_FN, //function def keyword (fn)
 	TOKEN_STRUCT,
+	TOKEN_IMPORT,
 	
 	TOKEN_IF,
 	TOKEN_ELSE,
@@ -87,23 +88,75 @@ typedef enum {
 	TOKEN_GREATER_EQUAL,
 } TokenType;
 
+//12 bytes, values that do not fit in the payload live in side tables of the owning TokenList
+//payload meaning depends on type:
+//	TOKEN_IDENTIFIER: index in compilation unit member "identifiers"
+//	TOKEN_INTEGER_TYPE, TOKEN_UNSIGNED_TYPE, TOKEN_FLOAT_TYPE: width in bits, 0 for size type (usize, isize)
+//	TOKEN_CHARACTER_LITERAL: the character
+//	TOKEN_INTEGER_LITERAL: index in token list member "integers"
+//	TOKEN_REAL_LITERAL: index in token list member "reals"
+//	TOKEN_STRING_LITERAL: index in token list member "strings"
+//	parentheses, brackets and braces: index of the matching token, TOKEN_NO_MATCH if there is none
+//	anything else: unused
+#define TOKEN_NO_MATCH UINT32_MAX
+
 typedef struct {
-	TokenType type;
-
-	size_t offset_in_source;
-	size_t length_in_source;
-	size_t line_number;
-	size_t column_number;
-
-	union {
-		uint64_t integer;
-		double real;
-		char character;
-		struct {char* text; size_t length;} string; //Not null-terminated. text points to a copy with escape characters handled
-		char* identifier;
-		size_t type_width; //in bits, 0 for size type (usize, isize)
-	} data;
+	uint8_t type; //TokenType
+	uint32_t offset_in_source;
+	uint32_t payload;
 } Token;
 
+typedef struct {
+	size_t offset; //in token list member "string_data"
+	size_t length;
+} TokenString;
+
+//every token of a source file, always ends with a TOKEN_EOF token
+typedef struct {
+	const char* source; //NULL if the source was streamed, only offsets into it are known then
+	size_t source_length;
+
+	Token* tokens;
+	size_t token_count;
+	size_t token_capacity;
+
+	//side tables
+	uint64_t* integers;
+	size_t integer_count;
+	size_t integer_capacity;
+
+	double* reals;
+	size_t real_count;
+	size_t real_capacity;
+
+	TokenString* strings;
+	size_t string_count;
+	size_t string_capacity;
+
+	//string literal text with escape characters handled, not null-terminated
+	char* string_data;
+	size_t string_data_length;
+	size_t string_data_capacity;
+
+	//offset of the first character of each line, line_starts[0] is always 0
+	uint32_t* line_starts;
+	size_t line_count;
+	size_t line_capacity;
+} TokenList;
+
 const char* tokenTypeToString(TokenType type);
-void printToken(Token token);
+void printToken(const TokenList* token_list, const Token* token);
+
+void tokenList_destroy(TokenList* token_list);
+
+//token must be of the matching literal type
+uint64_t tokenList_integer(const TokenList* token_list, const Token* token);
+double tokenList_real(const TokenList* token_list, const Token* token);
+//returned text is not null-terminated
+const char* tokenList_string(const TokenList* token_list, const Token* token, size_t* length);
+
+//recovered on demand as tokens do not store them
+//length is 0 if the source was streamed
+size_t tokenList_tokenLength(const TokenList* token_list, const Token* token);
+//binary search of the line start index, both are 1 based
+void tokenList_lineAndColumn(const TokenList* token_list, size_t offset_in_source, size_t* line, size_t* column);
@@ -1,58 +1,126 @@
 #include "tokeniser.h"
 
-#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <setjmp.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "compilation_unit.h"
+#include "simd_scan.h"
 #include "token.h"
 
-static FILE* source;
+//set while lexing speculatively, in parallel chunks or near the end of a stream window
+//errors there may be spurious so they jump back instead of exiting
+static _Thread_local jmp_buf* speculative_failure = NULL;
+static _Thread_local const char* speculative_failure_cause; //character that caused the last abandoned error
 
-static Token current_token;
-static Token next_token;
+//used by the wrappers that take no tokeniser, one per thread so they never interfere
+static _Thread_local Tokeniser default_tokeniser;
 
-//not super accurate
-static size_t line_number = 1;
-static size_t column_number = 1;
-
-typedef struct {
-	const char* keyword;
-	const size_t length;
-	TokenType type;
-} Keyword;
-static const Keyword KEYWORD_TABLE[] = {
-	{"fn", sizeof("fn") - sizeof(char), TOKEN_FN},
-	{"if", sizeof("if") - sizeof(char), TOKEN_IF},
-	{"else", sizeof("else") - sizeof(char), TOKEN_ELSE},
-	{"while", sizeof("while") - sizeof(char), TOKEN_WHILE},
-	{"for", sizeof("for") - sizeof(char), TOKEN_FOR},
-	{"return", sizeof("return") - sizeof(char), TOKEN_RETURN},
-
-	//not technically keywords but works best here
-	{"isize", sizeof("isize") - sizeof(char), TOKEN_INTEGER_TYPE},
-	{"usize", sizeof("usize") - sizeof(char), TOKEN_UNSIGNED_TYPE},
-	{"bool", sizeof("bool") - sizeof(char), TOKEN_BOOL_TYPE},
-	{"char", sizeof("char") - sizeof(char), TOKEN_CHARACTER_TYPE},
-
-	{"true", sizeof("true") - sizeof(char), TOKEN_TRUE},
-	{"false", sizeof("false") - sizeof(char), TOKEN_FALSE},
+//each character has exactly one class
+typedef enum {
+	CHARACTER_INVALID, //default for anything not listed
+	CHARACTER_SENTINEL, //'\0', either the padding after the source or a stray null in it
+	CHARACTER_WHITESPACE,
+	CHARACTER_DIGIT,
+	CHARACTER_LETTER, //includes underscore
+	CHARACTER_DOUBLE_QUOTE,
+	CHARACTER_SINGLE_QUOTE,
+	CHARACTER_OPERATOR, //starts an entry in PUNCTUATION_TABLE
+} CharacterClass;
+static const uint8_t CHARACTER_CLASS_TABLE[256] = {
+	['\0'] = CHARACTER_SENTINEL,
+	//whitespace
+	[' '] = CHARACTER_WHITESPACE, ['\t'] = CHARACTER_WHITESPACE, ['\n'] = CHARACTER_WHITESPACE,
+	['\v'] = CHARACTER_WHITESPACE, ['\f'] = CHARACTER_WHITESPACE, ['\r'] = CHARACTER_WHITESPACE,
+	//digits
+	['0'] = CHARACTER_DIGIT, ['1'] = CHARACTER_DIGIT, ['2'] = CHARACTER_DIGIT, ['3'] = CHARACTER_DIGIT, ['4'] = CHARACTER_DIGIT,
+	['5'] = CHARACTER_DIGIT, ['6'] = CHARACTER_DIGIT, ['7'] = CHARACTER_DIGIT, ['8'] = CHARACTER_DIGIT, ['9'] = CHARACTER_DIGIT,
+	//letters
+	['a'] = CHARACTER_LETTER, ['b'] = CHARACTER_LETTER, ['c'] = CHARACTER_LETTER, ['d'] = CHARACTER_LETTER, ['e'] = CHARACTER_LETTER, ['f'] = CHARACTER_LETTER, ['g'] = CHARACTER_LETTER,
+	['h'] = CHARACTER_LETTER, ['i'] = CHARACTER_LETTER, ['j'] = CHARACTER_LETTER, ['k'] = CHARACTER_LETTER, ['l'] = CHARACTER_LETTER, ['m'] = CHARACTER_LETTER,
+	['n'] = CHARACTER_LETTER, ['o'] = CHARACTER_LETTER, ['p'] = CHARACTER_LETTER, ['q'] = CHARACTER_LETTER, ['r'] = CHARACTER_LETTER, ['s'] = CHARACTER_LETTER, ['t'] = CHARACTER_LETTER,
+	['u'] = CHARACTER_LETTER, ['v'] = CHARACTER_LETTER, ['w'] = CHARACTER_LETTER, ['x'] = CHARACTER_LETTER, ['y'] = CHARACTER_LETTER, ['z'] = CHARACTER_LETTER,
+	['A'] = CHARACTER_LETTER, ['B'] = CHARACTER_LETTER, ['C'] = CHARACTER_LETTER, ['D'] = CHARACTER_LETTER, ['E'] = CHARACTER_LETTER, ['F'] = CHARACTER_LETTER, ['G'] = CHARACTER_LETTER,
+	['H'] = CHARACTER_LETTER, ['I'] = CHARACTER_LETTER, ['J'] = CHARACTER_LETTER, ['K'] = CHARACTER_LETTER, ['L'] = CHARACTER_LETTER, ['M'] = CHARACTER_LETTER,
+	['N'] = CHARACTER_LETTER, ['O'] = CHARACTER_LETTER, ['P'] = CHARACTER_LETTER, ['Q'] = CHARACTER_LETTER, ['R'] = CHARACTER_LETTER, ['S'] = CHARACTER_LETTER, ['T'] = CHARACTER_LETTER,
+	['U'] = CHARACTER_LETTER, ['V'] = CHARACTER_LETTER, ['W'] = CHARACTER_LETTER, ['X'] = CHARACTER_LETTER, ['Y'] = CHARACTER_LETTER, ['Z'] = CHARACTER_LETTER,
+	['_'] = CHARACTER_LETTER,
+	//literals
+	['"'] = CHARACTER_DOUBLE_QUOTE, ['\''] = CHARACTER_SINGLE_QUOTE,
+	//operators
+	['('] = CHARACTER_OPERATOR, [')'] = CHARACTER_OPERATOR, ['['] = CHARACTER_OPERATOR, [']'] = CHARACTER_OPERATOR, ['{'] = CHARACTER_OPERATOR,
+	['}'] = CHARACTER_OPERATOR, [';'] = CHARACTER_OPERATOR, [':'] = CHARACTER_OPERATOR, [','] = CHARACTER_OPERATOR, ['.'] = CHARACTER_OPERATOR,
+	['='] = CHARACTER_OPERATOR, ['+'] = CHARACTER_OPERATOR, ['-'] = CHARACTER_OPERATOR, ['*'] = CHARACTER_OPERATOR, ['/'] = CHARACTER_OPERATOR,
+	['%'] = CHARACTER_OPERATOR, ['&'] = CHARACTER_OPERATOR, ['|'] = CHARACTER_OPERATOR, ['^'] = CHARACTER_OPERATOR, ['~'] = CHARACTER_OPERATOR,
+	['<'] = CHARACTER_OPERATOR, ['>'] = CHARACTER_OPERATOR, ['!'] = CHARACTER_OPERATOR,
 };
-static const size_t KEYWORD_TABLE_LENGTH = sizeof(KEYWORD_TABLE) / sizeof(KEYWORD_TABLE[0]);
-//buffer should not be null terminated
-static TokenType findInKeywordTable(const char* buffer, size_t buffer_length) {
-	for (size_t i = 0; i < KEYWORD_TABLE_LENGTH; ++i) {
-		if (KEYWORD_TABLE[i].length != buffer_length) continue;
-		int comparison_result = memcmp(buffer, KEYWORD_TABLE[i].keyword, buffer_length);
-		if (comparison_result == 0) return KEYWORD_TABLE[i].type;
+
+static inline CharacterClass characterClass(char c) {
+	return CHARACTER_CLASS_TABLE[(unsigned char)c];
+}
+
+//true if word matches the null terminated keyword, word must be the same length as keyword
+#define MATCHES_KEYWORD(WORD, KEYWORD) (memcmp(WORD, KEYWORD, sizeof(KEYWORD) - sizeof(char)) == 0)
+
+//switching on length then first character means at most one memcmp per word
+//regardless of how many keywords exist
+//word should not be null terminated
+static TokenType findKeyword(const char* word, size_t word_length) {
+	switch (word_length) {
+		case 2:
+		switch (word[0]) {
+			case 'f': return MATCHES_KEYWORD(word, "fn") ? TOKEN_FN : TOKEN_NONE;
+			case 'i': return MATCHES_KEYWORD(word, "if") ? TOKEN_IF : TOKEN_NONE;
+			default: return TOKEN_NONE;
+		}
+
+		case 3:
+		switch (word[0]) {
+			case 'f': return MATCHES_KEYWORD(word, "for") ? TOKEN_FOR : TOKEN_NONE;
+			default: return TOKEN_NONE;
+		}
+
+		case 4:
+		switch (word[0]) {
+			case 'e': return MATCHES_KEYWORD(word, "else") ? TOKEN_ELSE : TOKEN_NONE;
+			case 't': return MATCHES_KEYWORD(word, "true") ? TOKEN_TRUE : TOKEN_NONE;
+			//not technically keywords but works best here
+			case 'b': return MATCHES_KEYWORD(word, "bool") ? TOKEN_BOOL_TYPE : TOKEN_NONE;
+			case 'c': return MATCHES_KEYWORD(word, "char") ? TOKEN_CHARACTER_TYPE : TOKEN_NONE;
+			default: return TOKEN_NONE;
+		}
+
+		case 5:
+		switch (word[0]) {
+			case 'w': return MATCHES_KEYWORD(word, "while") ? TOKEN_WHILE : TOKEN_NONE;
+			case 'f': return MATCHES_KEYWORD(word, "false") ? TOKEN_FALSE : TOKEN_NONE;
+			//size types, width is left as 0
+			case 'i': return MATCHES_KEYWORD(word, "isize") ? TOKEN_INTEGER_TYPE : TOKEN_NONE;
+			case 'u': return MATCHES_KEYWORD(word, "usize") ? TOKEN_UNSIGNED_TYPE : TOKEN_NONE;
+			default: return TOKEN_NONE;
+		}
+
+		case 6:
+		switch (word[0]) {
+			case 'i': return MATCHES_KEYWORD(word, "import") ? TOKEN_IMPORT : TOKEN_NONE;
+			case 'r': return MATCHES_KEYWORD(word, "return") ? TOKEN_RETURN : TOKEN_NONE;
+			case 's': return MATCHES_KEYWORD(word, "struct") ? TOKEN_STRUCT : TOKEN_NONE;
+			default: return TOKEN_NONE;
+		}
+
+		default: return TOKEN_NONE;
 	}
-	return TOKEN_NONE;
 }
 
-//MUST be sorted from longest length to shortest length
-//to prevent situations where << is identified as <
+//every operator and delimiter, compiled into the operator state machine below
+//order does not matter, the longest match always wins
 typedef struct {
 	const char* punctuation;
 	const size_t length;
@@ -104,387 +172,1268 @@ static const Punctuation PUNCTUATION_TABLE[] = {
 	{">", sizeof(">") - sizeof(char), TOKEN_GREATER},
 };
 static const size_t PUNCTUATION_TABLE_LENGTH = sizeof(PUNCTUATION_TABLE) / sizeof(PUNCTUATION_TABLE[0]);
-//buffer should not be null terminated, always 3 characters long
-static Punctuation findInPunctuationTable(const char* buffer) {
+//operator state machine built from PUNCTUATION_TABLE
+//each state is a prefix of at least one entry, transitions are indexed by the next character
+#define OPERATOR_STATE_LIMIT 64
+#define OPERATOR_DEAD_STATE 0
+#define OPERATOR_START_STATE 1
+static uint8_t operator_transitions[OPERATOR_STATE_LIMIT][256];
+static uint8_t operator_accepted_types[OPERATOR_STATE_LIMIT]; //TOKEN_NONE if the prefix is not an entry itself
+
+static void buildOperatorTransitions(void) {
+	size_t state_count = OPERATOR_START_STATE + 1;
 	for (size_t i = 0; i < PUNCTUATION_TABLE_LENGTH; ++i) {
-		int comparison_result = memcmp(buffer, PUNCTUATION_TABLE[i].punctuation, PUNCTUATION_TABLE[i].length);
-		if (comparison_result == 0) return PUNCTUATION_TABLE[i];
+		uint8_t state = OPERATOR_START_STATE;
+		for (size_t j = 0; j < PUNCTUATION_TABLE[i].length; ++j) {
+			unsigned char c = PUNCTUATION_TABLE[i].punctuation[j];
+			if (operator_transitions[state][c] == OPERATOR_DEAD_STATE) {
+				if (state_count >= OPERATOR_STATE_LIMIT) {
+					printf("ERROR: Operator state machine exceeded %d states!\n", OPERATOR_STATE_LIMIT);
+					exit(1);
+				}
+				operator_transitions[state][c] = state_count;
+				++state_count;
+			}
+			state = operator_transitions[state][c];
+		}
+		operator_accepted_types[state] = PUNCTUATION_TABLE[i].type;
 	}
-	Punctuation not_found = {"", 0, TOKEN_NONE};
-	return not_found;
 }
 
-static inline void unexpectedCharacter(char c, size_t index, size_t line, size_t column) {
-	printf("ERROR: Unexpected character '%c' at index: %zu, line: %zu, column: %zu!\n", c, index, line, column);
-	exit(1);
+//tables shared by every tokeniser, filled once whichever thread gets there first
+static pthread_once_t shared_tables_once = PTHREAD_ONCE_INIT;
+
+static void buildSharedTables(void) {
+	buildOperatorTransitions();
+	simdScan_init();
 }
 
-static void skipWhitespace(void) {
-	char c = fgetc(source);
-	while (isspace(c) && !feof(source)) {
-		if (c == '\n') {
-			++line_number;
-			column_number = 1;
-		} else {
-			++column_number;
-		}
-		c = fgetc(source);
+//grows list by doubling until it can hold required_count elements
+//used for the token list and all of its side tables
+static void* ensureListCapacity(void* list, size_t* capacity, size_t required_count, size_t element_size) {
+	if (required_count <= *capacity && list != NULL) return list;
+
+	size_t new_capacity = *capacity == 0 ? 16 : *capacity;
+	while (new_capacity < required_count) new_capacity *= 2;
+
+	void* new_list = realloc(list, new_capacity * element_size);
+	if (new_list == NULL) {
+		printf("ERROR: Failed to grow token list to %zu elements!\n", new_capacity);
+		exit(1);
+	}
+	*capacity = new_capacity;
+	return new_list;
+}
+
+static inline void appendToken(TokenList* token_list, Token token) {
+	if (token_list->token_count >= token_list->token_capacity) {
+		token_list->tokens = ensureListCapacity(token_list->tokens, &token_list->token_capacity, token_list->token_count + 1, sizeof(Token));
+	}
+	token_list->tokens[token_list->token_count] = token;
+	++token_list->token_count;
+}
+
+//the add functions return the index of the new element for use as a token payload
+
+static uint32_t addInteger(TokenList* token_list, uint64_t value) {
+	token_list->integers = ensureListCapacity(token_list->integers, &token_list->integer_capacity, token_list->integer_count + 1, sizeof(uint64_t));
+	token_list->integers[token_list->integer_count] = value;
+	return token_list->integer_count++;
+}
+
+static uint32_t addReal(TokenList* token_list, double value) {
+	token_list->reals = ensureListCapacity(token_list->reals, &token_list->real_capacity, token_list->real_count + 1, sizeof(double));
+	token_list->reals[token_list->real_count] = value;
+	return token_list->real_count++;
+}
+
+static uint32_t addString(TokenList* token_list, size_t offset, size_t length) {
+	token_list->strings = ensureListCapacity(token_list->strings, &token_list->string_capacity, token_list->string_count + 1, sizeof(TokenString));
+	token_list->strings[token_list->string_count] = (TokenString){offset, length};
+	return token_list->string_count++;
+}
+
+//adds the lines starting in [position, end) of source to the token list line start index
+static void addLineStarts(const Tokeniser* tokeniser, TokenList* token_list, const char* position, const char* end) {
+	size_t first_new_line = token_list->line_count;
+	while (position < end) {
+		token_list->line_starts = ensureListCapacity(
+			token_list->line_starts,
+			&token_list->line_capacity,
+			token_list->line_count + 32,
+			sizeof(uint32_t)
+		);
+		position = simdScan_findLineStarts(
+			tokeniser->source,
+			position,
+			end,
+			token_list->line_starts,
+			&token_list->line_count,
+			token_list->line_capacity
+		);
 	}
 
-	if (feof(source)) return;
-	fseek(source, -1, SEEK_CUR);
+	if (tokeniser->source_base_offset == 0) return;
+	for (size_t i = first_new_line; i < token_list->line_count; ++i) {
+		token_list->line_starts[i] += tokeniser->source_base_offset;
+	}
 }
 
-static void getNumberLiteral(Token* token, char first_char) {
-	int base = 10;
+//fills the token list line start index in one pass before lexing, so errors can be located at any point
+static void findLineStarts(const Tokeniser* tokeniser, TokenList* token_list) {
+	//rough guess at line density, the kernel needs 32 free slots to make progress
+	token_list->line_starts = ensureListCapacity(NULL, &token_list->line_capacity, token_list->source_length / 32 + 32, sizeof(uint32_t));
+	token_list->line_starts[0] = 0;
+	token_list->line_count = 1;
+
+	addLineStarts(tokeniser, token_list, tokeniser->source, tokeniser->source_end);
+}
+
+//cause is the character the error was found at, so a stream can tell if more input might fix it
+static inline void abandonIfSpeculative(const char* cause) {
+	if (speculative_failure == NULL) return;
+	speculative_failure_cause = cause;
+	longjmp(*speculative_failure, 1);
+}
+
+//line and column are only needed here, so they are looked up rather than tracked while scanning
+static void lexerError(const Tokeniser* tokeniser, const TokenList* token_list, const char* message, const char* position) {
+	abandonIfSpeculative(position);
+	size_t offset = tokeniser->source_base_offset + (position - tokeniser->source);
+	size_t line, column;
+	tokenList_lineAndColumn(token_list, offset, &line, &column);
+	printf("ERROR: %s at index: %zu, line: %zu, column: %zu!\n", message, offset, line, column);
+	exit(1);
+}
+
+static void unexpectedCharacter(const Tokeniser* tokeniser, const TokenList* token_list, const char* position) {
+	abandonIfSpeculative(position);
+	size_t offset = tokeniser->source_base_offset + (position - tokeniser->source);
+	size_t line, column;
+	tokenList_lineAndColumn(token_list, offset, &line, &column);
+	printf("ERROR: Unexpected character '%c' at index: %zu, line: %zu, column: %zu!\n", *position, offset, line, column);
+	exit(1);
+}
+
+static inline const char* skipWhitespace(const char* position) {
+	//most tokens are not preceded by whitespace, skip the kernel call for those
+	if (characterClass(*position) != CHARACTER_WHITESPACE) return position;
+	return simdScan_skipWhitespace(position);
+}
+
+//value of c as a digit of any base up to 16, 16 if it is not one
+static inline unsigned digitValue(char c) {
+	if ((unsigned char)(c - '0') <= 9) return c - '0';
+	if ((unsigned char)((c | 0x20) - 'a') <= 'f' - 'a') return (c | 0x20) - 'a' + 10;
+	return 16;
+}
+
+//every power of ten a double holds exactly
+static const double EXACT_POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+#define EXACT_POWER_OF_TEN_LIMIT (sizeof(EXACT_POWERS_OF_TEN) / sizeof(EXACT_POWERS_OF_TEN[0]) - 1)
+//largest integer below which every integer is exactly a double
+#define EXACT_DOUBLE_INTEGER_LIMIT ((uint64_t)1 << 53)
+
+//converts the literal in the same pass that finds its end
+static const char* getNumberLiteral(const Tokeniser* tokeniser, TokenList* token_list, Token* token, const char* position) {
+	const char* start = position;
+	unsigned base = 10;
 
 	//test for integer base
-	char second_char = fgetc(source);
-	if (first_char == '0' && !isdigit(second_char)) {
-		switch (second_char) {
+	if (position[0] == '0' && characterClass(position[1]) != CHARACTER_DIGIT) {
+		switch (position[1]) {
 			case 'b': base = 2; break;
 			case 'o': base = 8; break;
 			case 'x': base = 16; break;
 
-			default:
-			fseek(source, -1, SEEK_CUR); // go back to start if no base
-			break;
+			default: break;
 		}
-		//ensure base has proceding digit
-		char next_char = fgetc(source);
-		if (base != 10 && !isdigit(next_char)) {
-			unexpectedCharacter(next_char, ftell(source) - 1, line_number, column_number + 3);
+		if (base != 10) {
+			position += 2;
+			//ensure base has proceding digit
+			if (digitValue(*position) >= base) {
+				unexpectedCharacter(tokeniser, token_list, position);
+			}
 		}
-		fseek(source, -1, SEEK_CUR);
-	} else {
-		fseek(source, -1, SEEK_CUR); // go back to start if no base
 	}
 
-	bool real = false;
-	//skip to end of number
-	char c = fgetc(source);
-	while (isdigit(c) || c == '.') {
-		if (c == '.') {
-			real = true;
+	//accumulate digits, overflowing is an error rather than saturating
+	uint64_t value = 0;
+	bool overflow = false;
+	unsigned digit;
+	if (base == 10) {
+		while ((digit = (unsigned char)(*position - '0')) <= 9) {
+			overflow |= __builtin_mul_overflow(value, 10, &value);
+			overflow |= __builtin_add_overflow(value, digit, &value);
+			++position;
+		}
+	} else {
+		unsigned digit_bits = base == 2 ? 1 : base == 8 ? 3 : 4;
+		while ((digit = digitValue(*position)) < base) {
+			overflow |= (value >> (64 - digit_bits)) != 0;
+			value = (value << digit_bits) | digit;
+			++position;
+		}
+		//a decimal digit the base does not have, such as 0b12
+		if (characterClass(*position) == CHARACTER_DIGIT) {
+			lexerError(tokeniser, token_list, "Failed to fully convert integer literal", start);
 		}
-		c = fgetc(source);
 	}
-	fseek(source, -1, SEEK_CUR);
+
+	if (*position != '.') {
+		if (overflow) lexerError(tokeniser, token_list, "Integer literal does not fit in 64 bits", start);
+
+		token->type = TOKEN_INTEGER_LITERAL;
+		token->payload = addInteger(token_list, value);
+		return position;
+	}
 
 	//test for error
-	if (base != 10 && real) {
-		printf("ERROR: Disallowed based real literal at index: %zu, line: %zu, column: %zu!\n",
-			token->offset_in_source, line_number, column_number);
-		exit(1);
+	if (base != 10) {
+		lexerError(tokeniser, token_list, "Disallowed based real literal", start);
 	}
 
-	//set token variables
-	token->length_in_source = ftell(source) - token->offset_in_source;
-	if (real) {
-		token->type = TOKEN_REAL_LITERAL;
-		//prepare string buffer
-		char buffer[token->length_in_source + 1];
-		buffer[token->length_in_source] = '\0';
-		fseek(source, token->offset_in_source, SEEK_SET);
-		fread(buffer, sizeof(char), token->length_in_source, source);
-		//convert string buffer
-		char* end_ptr;
-		token->data.real = strtod(buffer, &end_ptr);
-		if (end_ptr != buffer + token->length_in_source) {
-			printf("ERROR: Failed to fully convert real literal at index: %zu, line: %zu, column: %zu!\n",
-				token->offset_in_source, line_number, column_number);
-			exit(1);
-		}
+	//keep accumulating so value holds every digit with the point removed
+	++position;
+	const char* fraction = position;
+	while ((digit = (unsigned char)(*position - '0')) <= 9) {
+		overflow |= __builtin_mul_overflow(value, 10, &value);
+		overflow |= __builtin_add_overflow(value, digit, &value);
+		++position;
+	}
+	size_t fraction_digit_count = position - fraction;
+
+	//a second point, as in 1.2.3
+	if (*position == '.') {
+		lexerError(tokeniser, token_list, "Failed to fully convert real literal", start);
+	}
+
+	token->type = TOKEN_REAL_LITERAL;
+	double real_value;
+	if (!overflow && value <= EXACT_DOUBLE_INTEGER_LIMIT && fraction_digit_count <= EXACT_POWER_OF_TEN_LIMIT) {
+		//both operands are exact so the single division rounds correctly (Clinger's fast path)
+		real_value = (double)value / EXACT_POWERS_OF_TEN[fraction_digit_count];
 	} else {
-		token->type = TOKEN_INTEGER_LITERAL;
-		//prepare string buffer
-		//fancy handling as we want to ignore the base syntax
-		size_t buffer_length = base == 10 ? token->length_in_source + 1 : token->length_in_source - 1;
-		size_t copy_index = base == 10 ? token->offset_in_source : token->offset_in_source + 2;
-		char buffer[buffer_length];
-		buffer[buffer_length - 1] = '\0';
-		fseek(source, copy_index, SEEK_SET);
-		fread(buffer, sizeof(char), buffer_length - 1, source);
-		//convert string buffer
+		//too many significant digits, fall back to strtod on a null terminated copy
+		size_t length = position - start;
+		char buffer[length + 1];
+		memcpy(buffer, start, length);
+		buffer[length] = '\0';
 		char* end_ptr;
-		token->data.integer = strtoll(buffer, &end_ptr, base);
-		if (end_ptr != buffer + buffer_length - 1) {
-			printf("ERROR: Failed to fully convert integer literal at index: %zu, line: %zu, column: %zu!\n",
-				token->offset_in_source, line_number, column_number);
-			exit(1);
+		real_value = strtod(buffer, &end_ptr);
+		if (end_ptr != buffer + length) {
+			lexerError(tokeniser, token_list, "Failed to fully convert real literal", start);
 		}
 	}
+	token->payload = addReal(token_list, real_value);
+
+	return position;
 }
 
-//passing n will return \n
-static char escapeCharacterToCharacter(char c) {
-	switch (c) {
+//escaped points at the character after the backslash, passing n will return \n
+static char escapeCharacterToCharacter(const char* escaped) {
+	switch (*escaped) {
 		case 'n': return '\n';
 		case '\\': return '\\';
 
 		default:
+		abandonIfSpeculative(escaped);
 		printf("ERROR: Attempted to escape non escape character!");
 		exit(1);
 	}
 }
 
-static void getCharacterLiteral(Token* token) {
+//starts on opening quote
+static const char* getCharacterLiteral(const Tokeniser* tokeniser, const TokenList* token_list, Token* token, const char* position) {
 	token->type = TOKEN_CHARACTER_LITERAL;
-	char second_char = fgetc(source);
-	if (second_char != '\\') {
+	++position;
+
+	if (*position != '\\') {
 		//not an escape character
-		token->length_in_source = 3;
-		token->data.character = second_char;
-		//ensure proper syntax
-		char final_char = fgetc(source);
-		if (final_char != '\'') unexpectedCharacter(final_char, ftell(source) - 1, line_number, column_number + 2);
-	}
-	//handle escape character
-	token->length_in_source = 4;
-	token->data.character = escapeCharacterToCharacter(fgetc(source));
+		token->payload = (unsigned char)*position;
+		++position;
+	} else {
+		//handle escape character
+		token->payload = (unsigned char)escapeCharacterToCharacter(position + 1);
+		position += 2;
+	}
+
 	//ensure proper syntax
-	char final_char = fgetc(source);
-	if (final_char != '\'') unexpectedCharacter(final_char, ftell(source) - 1, line_number, column_number + 2);
+	if (*position != '\'') unexpectedCharacter(tokeniser, token_list, position);
+	return position + 1;
 }
 
-static void getStringLiteral(Token* token) {
+//starts on opening quote
+//decodes in a single pass straight into the token list string data, copying whole runs between escapes at once
+static const char* getStringLiteral(const Tokeniser* tokeniser, TokenList* token_list, Token* token, const char* position) {
+	const char* start = position;
 	token->type = TOKEN_STRING_LITERAL;
+	++position;
+
+	size_t text_offset = token_list->string_data_length;
+	while (true) {
+		const char* special = simdScan_findStringSpecial(position);
+
+		//hitting the padding means the literal was never closed
+		if (*special == '\0' && special >= tokeniser->source_end) {
+			abandonIfSpeculative(special);
+			lexerError(tokeniser, token_list, "Could not process string literal", start);
+		}
+
+		//make room for the run and a possible escaped or stray null character
+		size_t run_length = special - position;
+		token_list->string_data = ensureListCapacity(
+			token_list->string_data,
+			&token_list->string_data_capacity,
+			token_list->string_data_length + run_length + 1,
+			sizeof(token_list->string_data[0])
+		);
+		char* text_end = token_list->string_data + token_list->string_data_length;
+		memcpy(text_end, position, run_length);
+		token_list->string_data_length += run_length;
 
-	//determine string data length
-	size_t true_literal_length = 0;
-	bool escaped = false;
-	char c = fgetc(source);
-	while (!feof(source) && !(c == '"' && !escaped)) {
-		//escape character logic
-		if (c == '\\' && !escaped) {
-			escaped = true;
+		if (*special == '"') {
+			position = special + 1;
+			break;
+		}
+		if (*special == '\\') {
+			text_end[run_length] = escapeCharacterToCharacter(special + 1);
+			position = special + 2;
 		} else {
-			++true_literal_length;
-			escaped = false;
+			//stray null inside the source, keep it as is
+			text_end[run_length] = '\0';
+			position = special + 1;
 		}
+		++token_list->string_data_length;
+	}
+
+	token->payload = addString(token_list, text_offset, token_list->string_data_length - text_offset);
+	return position;
+}
+
+//widest integer llvm can make, a sized type wider than this is an error like an integer literal that does not fit
+#define TYPE_WIDTH_LIMIT ((uint32_t)1 << 23)
 
-		c = fgetc(source);
+//handles keywords, builtin types and sized types such as i32, u8 or f64
+static const char* getIdentifierOrKeyword(const Tokeniser* tokeniser, CompilationUnit* compilation_unit, TokenList* token_list, Token* token, const char* position) {
+	const char* start = position;
+
+	//get length
+	position = simdScan_findIdentifierEnd(position + 1);
+	size_t length = position - start;
+
+	//test if a sized type, only words starting with i, u or f need their digits checked
+	if (length > 1) {
+		switch (start[0]) {
+			case 'i': token->type = TOKEN_INTEGER_TYPE; break;
+			case 'u': token->type = TOKEN_UNSIGNED_TYPE; break;
+			case 'f': token->type = TOKEN_FLOAT_TYPE; break;
+
+			default: break;
+		}
+	}
+	if (token->type != TOKEN_NONE) {
+		//accumulating stops once over the limit so the width can never wrap
+		uint32_t type_width = 0;
+		const char* digit = start + 1;
+		while (characterClass(*digit) == CHARACTER_DIGIT) {
+			if (type_width <= TYPE_WIDTH_LIMIT) type_width = type_width * 10 + (*digit - '0');
+			++digit;
+		}
+		if (digit == position) {
+			if (type_width > TYPE_WIDTH_LIMIT) lexerError(tokeniser, token_list, "Type width is more than the 8388608 bit limit", start);
+			token->payload = type_width;
+			return position;
+		}
+		token->type = TOKEN_NONE;
 	}
 
-	//ensure proper syntax
-	if (c != '"') {
-		printf("ERROR: Could not process string literal at index: %zu, line: %zu, column: %zu!\n",
-			token->offset_in_source, line_number, column_number);
+	//test if a keyword
+	token->type = findKeyword(start, length);
+	if (token->type != TOKEN_NONE) return position; //if its a keyword we are done
+
+	//we can now assume its an identifier
+	//intern straight from the source so the parser never has to copy or compare it
+	token->type = TOKEN_IDENTIFIER;
+	if (compilation_unit == NULL) {
+		//speculative, interned in source order once stitched
+		token->payload = length;
+	} else {
+		token->payload = compilationUnit_getOrAddIdentifierIndex(compilation_unit, start, length);
+	}
+
+	return position;
+}
+
+//longest match through the operator state machine
+static const char* getOperator(Token* token, const char* position) {
+	const char* accepted_end = position + 1; //erroneous tokens are one character long
+	token->type = TOKEN_NONE;
+
+	//'\0' has no transitions so the padding stops this loop
+	uint8_t state = operator_transitions[OPERATOR_START_STATE][(unsigned char)*position];
+	while (state != OPERATOR_DEAD_STATE) {
+		++position;
+		if (operator_accepted_types[state] != TOKEN_NONE) {
+			token->type = operator_accepted_types[state];
+			accepted_end = position;
+		}
+		state = operator_transitions[state][(unsigned char)*position];
+	}
+
+	return accepted_end;
+}
+
+//scans the token starting exactly at position into token and returns its end
+//literal values go to the side tables of token_list
+//compilation_unit may be NULL when lexing speculatively, identifiers then hold their length instead of being interned
+static const char* scanToken(const Tokeniser* tokeniser, CompilationUnit* compilation_unit, TokenList* token_list, Token* token, const char* position) {
+	//initialise token
+	token->type = TOKEN_NONE; //default, will be overwritten
+	token->offset_in_source = tokeniser->source_base_offset + (position - tokeniser->source);
+	token->payload = 0; //default, will be overwritten
+
+	switch (characterClass(*position)) {
+		case CHARACTER_DIGIT: return getNumberLiteral(tokeniser, token_list, token, position);
+		case CHARACTER_LETTER: return getIdentifierOrKeyword(tokeniser, compilation_unit, token_list, token, position);
+		case CHARACTER_DOUBLE_QUOTE: return getStringLiteral(tokeniser, token_list, token, position);
+		case CHARACTER_SINGLE_QUOTE: return getCharacterLiteral(tokeniser, token_list, token, position);
+		case CHARACTER_OPERATOR: return getOperator(token, position);
+
+		case CHARACTER_SENTINEL:
+		//test eof
+		if (position >= tokeniser->source_end) {
+			token->type = TOKEN_EOF;
+			return position;
+		}
+		//otherwise a stray '\0' in the source
+		return position + 1;
+
+		//return erroneous token
+		default: return position + 1;
+	}
+}
+
+//same as scanToken without a compilation unit, but returns NULL instead of reporting errors
+//speculative_failure_cause is then the character the error was found at
+static const char* scanTokenSpeculatively(const Tokeniser* tokeniser, TokenList* token_list, Token* token, const char* position) {
+	jmp_buf failure;
+	if (setjmp(failure) != 0) {
+		speculative_failure = NULL;
+		return NULL;
+	}
+
+	speculative_failure = &failure;
+	const char* token_end = scanToken(tokeniser, NULL, token_list, token, position);
+	speculative_failure = NULL;
+	return token_end;
+}
+
+//scans the token starting at or after scan_position and advances scan_position past it
+static Token getToken(Tokeniser* tokeniser, CompilationUnit* compilation_unit) {
+	Token token;
+	tokeniser->scan_position = scanToken(tokeniser, compilation_unit, &compilation_unit->token_list, &token, skipWhitespace(tokeniser->scan_position));
+	return token;
+}
+
+//resets the lexer onto the source of compilation_unit and prepares its token list
+static void beginTokenising(Tokeniser* tokeniser, CompilationUnit* compilation_unit) {
+	TokenList* token_list = &compilation_unit->token_list;
+
+	//token offsets are 32 bit
+	if (compilation_unit->source_length > UINT32_MAX) {
+		printf("ERROR: Source file is larger than the %" PRIu32 " byte limit!\n", UINT32_MAX);
 		exit(1);
 	}
 
-	//allocate string memory
-	char* string_ptr = malloc(true_literal_length);
-	if (string_ptr == NULL) {
-		printf("ERROR: Failed to allocate memory for string literal!\n");
+	tokeniser->source = compilation_unit->source;
+	tokeniser->source_end = compilation_unit->source + compilation_unit->source_length;
+	tokeniser->scan_position = compilation_unit->source;
+	tokeniser->source_base_offset = 0;
+
+	//reset state
+	pthread_once(&shared_tables_once, buildSharedTables);
+
+	memset(token_list, 0, sizeof(*token_list));
+	token_list->source = compilation_unit->source;
+	token_list->source_length = compilation_unit->source_length;
+	findLineStarts(tokeniser, token_list);
+
+	//rough guess at token density to avoid most reallocations
+	token_list->tokens = ensureListCapacity(NULL, &token_list->token_capacity, compilation_unit->source_length / 4 + 1, sizeof(Token));
+}
+
+typedef struct {
+	uint32_t* token_indices;
+	size_t count;
+	size_t capacity;
+} DelimiterStack;
+
+//points every parenthesis, bracket and brace at its match so the parser can jump straight over them
+//each kind is matched on its own, the same as counting its depth
+static void matchDelimiters(TokenList* token_list) {
+	DelimiterStack stacks[3];
+	memset(stacks, 0, sizeof(stacks));
+
+	for (size_t i = 0; i < token_list->token_count; ++i) {
+		Token* token = token_list->tokens + i;
+		DelimiterStack* stack;
+		bool opening;
+		switch (token->type) {
+			case TOKEN_PARENTHESIS_LEFT:  stack = stacks + 0; opening = true; break;
+			case TOKEN_PARENTHESIS_RIGHT: stack = stacks + 0; opening = false; break;
+			case TOKEN_BRACKET_LEFT:      stack = stacks + 1; opening = true; break;
+			case TOKEN_BRACKET_RIGHT:     stack = stacks + 1; opening = false; break;
+			case TOKEN_BRACE_LEFT:        stack = stacks + 2; opening = true; break;
+			case TOKEN_BRACE_RIGHT:       stack = stacks + 2; opening = false; break;
+
+			default: continue;
+		}
+
+		//unmatched until proven otherwise
+		token->payload = TOKEN_NO_MATCH;
+		if (opening) {
+			stack->token_indices = ensureListCapacity(stack->token_indices, &stack->capacity, stack->count + 1, sizeof(uint32_t));
+			stack->token_indices[stack->count] = i;
+			++stack->count;
+		} else if (stack->count > 0) {
+			--stack->count;
+			uint32_t opening_index = stack->token_indices[stack->count];
+			token->payload = opening_index;
+			token_list->tokens[opening_index].payload = i;
+		}
+	}
+
+	for (size_t i = 0; i < 3; ++i) {
+		free(stacks[i].token_indices);
+	}
+}
+
+//lexes sequentially from scan_position up to and including the eof token
+static void finishTokenising(Tokeniser* tokeniser, CompilationUnit* compilation_unit) {
+	Token token;
+	do {
+		token = getToken(tokeniser, compilation_unit);
+		appendToken(&compilation_unit->token_list, token);
+	} while (token.type != TOKEN_EOF);
+
+	matchDelimiters(&compilation_unit->token_list);
+}
+
+/*
+
+streaming
+
+sources that are not regular files, such as pipes, are read through a window that only has to hold
+the token being lexed, tokens still get offsets into the whole input but the text is not kept
+
+*/
+
+#define STREAM_WINDOW_SIZE (64 * 1024)
+//tokens ending this close to the window end might continue in input not read yet,
+//longer than any operator so the operator state machine never needs more
+#define STREAM_LOOKAHEAD 4
+
+typedef struct {
+	int file_descriptor;
+	char* buffer; //followed by SOURCE_PADDING zero bytes
+	size_t capacity; //excluding the padding
+	size_t length;
+	bool input_finished;
+} StreamWindow;
+
+//moves the text from keep onwards to the front of the window and reads more input after it
+//the window only grows when keep is already at the front of a full window, so its size is bounded by the longest token
+static void refillWindow(Tokeniser* tokeniser, StreamWindow* window, TokenList* token_list, const char* keep) {
+	size_t kept_length = window->buffer + window->length - keep;
+	memmove(window->buffer, keep, kept_length);
+	tokeniser->source_base_offset += keep - window->buffer;
+	window->length = kept_length;
+
+	if (window->length == window->capacity) {
+		window->capacity *= 2;
+		window->buffer = realloc(window->buffer, window->capacity + SOURCE_PADDING);
+		if (window->buffer == NULL) {
+			printf("ERROR: Failed to grow source stream window to %zu bytes!\n", window->capacity);
+			exit(1);
+		}
+	}
+
+	//read may return early so loop until the window is full or the input ends
+	size_t read_start = window->length;
+	while (window->length < window->capacity) {
+		ssize_t read_result = read(window->file_descriptor, window->buffer + window->length, window->capacity - window->length);
+		if (read_result < 0) {
+			printf("ERROR: Failed to read source stream!\n");
+			exit(1);
+		}
+		if (read_result == 0) {
+			window->input_finished = true;
+			break;
+		}
+		window->length += read_result;
+	}
+	memset(window->buffer + window->length, 0, SOURCE_PADDING);
+
+	//token offsets are 32 bit
+	if (tokeniser->source_base_offset + window->length > UINT32_MAX) {
+		printf("ERROR: Source stream is larger than the %" PRIu32 " byte limit!\n", UINT32_MAX);
 		exit(1);
 	}
 
-	//set token variables
-	token->length_in_source = ftell(source) - token->offset_in_source;
-	token->data.string.length = true_literal_length;
-	token->data.string.text = string_ptr;
+	tokeniser->source = window->buffer;
+	tokeniser->source_end = window->buffer + window->length;
+	tokeniser->scan_position = window->buffer;
+	addLineStarts(tokeniser, token_list, window->buffer + read_start, tokeniser->source_end);
+}
 
-	//insert string literal into allocated memory
-	fseek(source, token->offset_in_source + 1, SEEK_SET);
-	for (size_t i = 0; i < token->data.string.length; ++i) {
-		char c = fgetc(source);
-		if (c == '\\') {
-			char escape = fgetc(source);
-			token->data.string.text[i] = escapeCharacterToCharacter(escape);
-		} else {
-			token->data.string.text[i] = c;
+static void tokeniseStream(Tokeniser* tokeniser, CompilationUnit* compilation_unit) {
+	TokenList* token_list = &compilation_unit->token_list;
+
+	//reset state
+	pthread_once(&shared_tables_once, buildSharedTables);
+	tokeniser->source_base_offset = 0;
+
+	memset(token_list, 0, sizeof(*token_list));
+	token_list->line_starts = ensureListCapacity(NULL, &token_list->line_capacity, STREAM_WINDOW_SIZE / 32, sizeof(uint32_t));
+	token_list->line_starts[0] = 0;
+	token_list->line_count = 1;
+
+	StreamWindow window;
+	window.file_descriptor = compilation_unit->source_descriptor;
+	window.capacity = STREAM_WINDOW_SIZE;
+	window.length = 0;
+	window.input_finished = false;
+	window.buffer = malloc(window.capacity + SOURCE_PADDING);
+	if (window.buffer == NULL) {
+		printf("ERROR: Failed to allocate source stream window!\n");
+		exit(1);
+	}
+	refillWindow(tokeniser, &window, token_list, window.buffer);
+
+	while (true) {
+		const char* position = skipWhitespace(tokeniser->scan_position);
+		Token token;
+
+		//all input is in the window, lex normally
+		if (window.input_finished) {
+			tokeniser->scan_position = scanToken(tokeniser, compilation_unit, token_list, &token, position);
+			appendToken(token_list, token);
+			if (token.type == TOKEN_EOF) break;
+			continue;
 		}
+
+		//otherwise the token may be cut off by the window end, so lex it speculatively and keep its side table entries undoable
+		size_t integer_count = token_list->integer_count;
+		size_t real_count = token_list->real_count;
+		size_t string_count = token_list->string_count;
+		size_t string_data_length = token_list->string_data_length;
+
+		const char* token_end = scanTokenSpeculatively(tokeniser, token_list, &token, position);
+
+		bool cut_off = token_end == NULL
+			? speculative_failure_cause + STREAM_LOOKAHEAD >= tokeniser->source_end
+			: token_end + STREAM_LOOKAHEAD > tokeniser->source_end;
+		if (cut_off) {
+			token_list->integer_count = integer_count;
+			token_list->real_count = real_count;
+			token_list->string_count = string_count;
+			token_list->string_data_length = string_data_length;
+			refillWindow(tokeniser, &window, token_list, position);
+			continue;
+		}
+
+		//a genuine error, lex again for real to report it
+		if (token_end == NULL) scanToken(tokeniser, compilation_unit, token_list, &token, position);
+
+		if (token.type == TOKEN_IDENTIFIER) {
+			token.payload = compilationUnit_getOrAddIdentifierIndex(compilation_unit, position, token.payload);
+		}
+		appendToken(token_list, token);
+		tokeniser->scan_position = token_end;
 	}
+
+	matchDelimiters(token_list);
+
+	//the text is gone once the window is freed
+	token_list->source = NULL;
+	token_list->source_length = tokeniser->source_base_offset + window.length;
+	compilation_unit->source_length = token_list->source_length;
+	free(window.buffer);
+	tokeniser->source = NULL;
+	tokeniser->source_end = NULL;
+	tokeniser->scan_position = NULL;
+	tokeniser->source_base_offset = 0;
 }
 
-//only changes token if a variable type identifier
-static void getVariableSizeTypeIdentifier(Token* token, char first_char) {
-	//test for correct character
-	if (first_char != 'i' && first_char != 'u' && first_char != 'f') {
+void tokeniser_tokenise(Tokeniser* tokeniser, CompilationUnit* compilation_unit) {
+	if (compilation_unit->source == NULL) {
+		tokeniseStream(tokeniser, compilation_unit);
 		return;
 	}
 
-	char c = fgetc(source);
+	beginTokenising(tokeniser, compilation_unit);
+	finishTokenising(tokeniser, compilation_unit);
+}
+
+/*
 
-	//ensure proceeding character is a number
-	if (!isdigit(c)) {
-		fseek(source, token->offset_in_source + 1, SEEK_SET);
-		return;
+parallel lexing
+
+the tokeniser->source is split into chunks at newlines and each chunk is lexed speculatively on its own thread,
+a chunk may start inside a string or character literal so its tokens are only trusted once
+sequential lexing reaches one of their start offsets, lexing depends on nothing but the start position
+so every later token of the chunk then matches too
+
+*/
+
+//smaller sources are not worth starting threads for
+#define PARALLEL_LEX_THRESHOLD (1 << 20)
+//more chunks than threads so a slow chunk does not hold up the rest
+#define PARALLEL_LEX_CHUNKS_PER_THREAD 4
+
+typedef struct {
+	const char* start; //source start or just after a newline
+	const char* end;
+	//tokens starting before end, identifiers hold their length and literals index the chunk side tables
+	TokenList token_list;
+	const char* scan_end; //end of the last token lexed, an error stops the chunk early
+	bool done;
+} LexChunk;
+
+typedef struct {
+	const Tokeniser* tokeniser; //only read while chunks are lexed
+	LexChunk* chunks;
+	size_t chunk_count;
+	size_t next_chunk; //taken atomically, in order so stitching can start early
+	pthread_mutex_t mutex;
+	pthread_cond_t chunk_done;
+} LexPool;
+
+static void lexChunk(const Tokeniser* tokeniser, LexChunk* chunk) {
+	TokenList* token_list = &chunk->token_list;
+	token_list->source = tokeniser->source;
+	token_list->source_length = tokeniser->source_end - tokeniser->source;
+	chunk->scan_end = chunk->start;
+
+	const char* position = skipWhitespace(chunk->start);
+	while (position < chunk->end) {
+		Token token;
+		const char* token_end = scanTokenSpeculatively(tokeniser, token_list, &token, position);
+		if (token_end == NULL) return;
+
+		appendToken(token_list, token);
+		chunk->scan_end = token_end;
+		position = skipWhitespace(token_end);
 	}
+}
+
+static void* lexWorker(void* argument) {
+	LexPool* pool = argument;
+	while (true) {
+		size_t chunk_index = __atomic_fetch_add(&pool->next_chunk, 1, __ATOMIC_RELAXED);
+		if (chunk_index >= pool->chunk_count) return NULL;
+
+		lexChunk(pool->tokeniser, &pool->chunks[chunk_index]);
 
-	//find end of numbers
-	while (isdigit(c)) {
-		c = fgetc(source);
+		pthread_mutex_lock(&pool->mutex);
+		pool->chunks[chunk_index].done = true;
+		pthread_cond_broadcast(&pool->chunk_done);
+		pthread_mutex_unlock(&pool->mutex);
 	}
+}
 
-	//ensure not an identifier instead
-	if (isalnum(c) || c == '_') {
-		fseek(source, token->offset_in_source + 1, SEEK_SET);
-		return;
+//interns identifiers and moves literal values into the compilation unit side tables in source order,
+//so indices come out exactly as sequential lexing would give them
+static void appendChunkTokens(const Tokeniser* tokeniser, CompilationUnit* compilation_unit, const TokenList* chunk_list, size_t first_token) {
+	TokenList* token_list = &compilation_unit->token_list;
+	token_list->tokens = ensureListCapacity(
+		token_list->tokens,
+		&token_list->token_capacity,
+		token_list->token_count + chunk_list->token_count - first_token,
+		sizeof(Token)
+	);
+
+	for (size_t i = first_token; i < chunk_list->token_count; ++i) {
+		Token token = chunk_list->tokens[i];
+		switch (token.type) {
+			case TOKEN_IDENTIFIER:
+			token.payload = compilationUnit_getOrAddIdentifierIndex(compilation_unit, tokeniser->source + token.offset_in_source, token.payload);
+			break;
+
+			case TOKEN_INTEGER_LITERAL: token.payload = addInteger(token_list, chunk_list->integers[token.payload]); break;
+			case TOKEN_REAL_LITERAL: token.payload = addReal(token_list, chunk_list->reals[token.payload]); break;
+
+			case TOKEN_STRING_LITERAL:;
+			TokenString string = chunk_list->strings[token.payload];
+			token_list->string_data = ensureListCapacity(
+				token_list->string_data,
+				&token_list->string_data_capacity,
+				token_list->string_data_length + string.length,
+				sizeof(token_list->string_data[0])
+			);
+			memcpy(token_list->string_data + token_list->string_data_length, chunk_list->string_data + string.offset, string.length);
+			token.payload = addString(token_list, token_list->string_data_length, string.length);
+			token_list->string_data_length += string.length;
+			break;
+
+			default: break;
+		}
+		token_list->tokens[token_list->token_count] = token;
+		++token_list->token_count;
 	}
+}
 
-	//set token data
-	switch (first_char) {
-		case 'i': token->type = TOKEN_INTEGER_TYPE; break;
-		case 'u': token->type = TOKEN_UNSIGNED_TYPE; break;
-		case 'f': token->type = TOKEN_FLOAT_TYPE; break;
+//continues sequential lexing from scan_position through every token starting in chunk,
+//taking the chunk tokens wholesale once a token boundary lines up
+static void stitchChunk(Tokeniser* tokeniser, CompilationUnit* compilation_unit, const LexChunk* chunk) {
+	const TokenList* chunk_list = &chunk->token_list;
+	size_t chunk_index = 0;
 
-		default:
-		printf("ERROR: Reached supposedly unreachable code in getVariableSizeTypeIdentifier() in tokeniser.c!\n");
-		exit(1);
+	while (true) {
+		const char* position = skipWhitespace(tokeniser->scan_position);
+		if (position >= chunk->end) return;
+
+		//skip chunk tokens that began inside tokens already taken
+		size_t offset = position - tokeniser->source;
+		while (chunk_index < chunk_list->token_count && chunk_list->tokens[chunk_index].offset_in_source < offset) {
+			++chunk_index;
+		}
+
+		if (chunk_index < chunk_list->token_count && chunk_list->tokens[chunk_index].offset_in_source == offset) {
+			appendChunkTokens(tokeniser, compilation_unit, chunk_list, chunk_index);
+			chunk_index = chunk_list->token_count;
+			//if the chunk stopped on an error this carries on sequentially and reports it properly
+			tokeniser->scan_position = chunk->scan_end;
+			continue;
+		}
+
+		//out of sync, lex one token sequentially
+		appendToken(&compilation_unit->token_list, getToken(tokeniser, compilation_unit));
 	}
-	token->length_in_source = ftell(source) - token->offset_in_source - 1;
+}
 
-	char buffer[token->length_in_source];
-	fseek(source, token->offset_in_source + 1, SEEK_SET);
-	fread(buffer, sizeof(char), token->length_in_source - 1, source);
-	buffer[token->length_in_source - 1] = '\0';
+void tokeniser_tokeniseParallel(Tokeniser* tokeniser, CompilationUnit* compilation_unit, size_t thread_count) {
+	//streamed sources are never whole in memory so are always lexed sequentially
+	if (thread_count < 2 || compilation_unit->source == NULL || compilation_unit->source_length < PARALLEL_LEX_THRESHOLD) {
+		tokeniser_tokenise(tokeniser, compilation_unit);
+		return;
+	}
+	beginTokenising(tokeniser, compilation_unit);
 
-	char* end_ptr;
-	size_t type_width = strtoll(buffer, &end_ptr, 10);
-	if (end_ptr != buffer + token->length_in_source - 1) {
-		printf("ERROR: Failed to fully convert type identifier bit width at index: %zu, line: %zu, column: %zu!\n",
-			token->offset_in_source, line_number, column_number);
+	//split at newlines into roughly equal chunks
+	LexPool pool;
+	pool.tokeniser = tokeniser;
+	pool.chunk_count = thread_count * PARALLEL_LEX_CHUNKS_PER_THREAD;
+	pool.chunks = calloc(pool.chunk_count, sizeof(LexChunk));
+	if (pool.chunks == NULL) {
+		printf("ERROR: Failed to allocate lexer chunks!\n");
 		exit(1);
 	}
-	token->data.type_width = type_width;
+	size_t target_length = compilation_unit->source_length / pool.chunk_count;
+	const char* chunk_start = tokeniser->source;
+	for (size_t i = 0; i < pool.chunk_count; ++i) {
+		const char* chunk_end = tokeniser->source_end;
+		if (i + 1 < pool.chunk_count && (size_t)(tokeniser->source_end - chunk_start) > target_length) {
+			const char* newline = memchr(chunk_start + target_length, '\n', tokeniser->source_end - (chunk_start + target_length));
+			if (newline != NULL) chunk_end = newline + 1;
+		}
+		pool.chunks[i].start = chunk_start;
+		pool.chunks[i].end = chunk_end;
+		chunk_start = chunk_end;
+	}
+	pool.next_chunk = 0;
+	pthread_mutex_init(&pool.mutex, NULL);
+	pthread_cond_init(&pool.chunk_done, NULL);
+
+	pthread_t threads[thread_count];
+	for (size_t i = 0; i < thread_count; ++i) {
+		if (pthread_create(&threads[i], NULL, lexWorker, &pool) != 0) {
+			printf("ERROR: Failed to start lexer thread!\n");
+			exit(1);
+		}
+	}
+
+	//stitch each chunk as soon as it is done while later ones are still being lexed
+	for (size_t i = 0; i < pool.chunk_count; ++i) {
+		pthread_mutex_lock(&pool.mutex);
+		while (!pool.chunks[i].done) pthread_cond_wait(&pool.chunk_done, &pool.mutex);
+		pthread_mutex_unlock(&pool.mutex);
+
+		stitchChunk(tokeniser, compilation_unit, &pool.chunks[i]);
+		tokenList_destroy(&pool.chunks[i].token_list);
+	}
+
+	for (size_t i = 0; i < thread_count; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_cond_destroy(&pool.chunk_done);
+	pthread_mutex_destroy(&pool.mutex);
+	free(pool.chunks);
+
+	finishTokenising(tokeniser, compilation_unit);
 }
 
-static void getIdentifierOrKeyword(Token* token) {
-	//get length
-	char c = fgetc(source);
-	while (isalnum(c) || c == '_') {
-		c = fgetc(source);
+/*
+
+incremental lexing
+
+lexing depends on nothing but the start position, so after an edit only the tokens from just before it
+are lexed again until one starts where an old token after the edit started, every later token is then the same but moved
+
+*/
+
+//scans like scanToken but never stops on errors, the erroneous text becomes a single TOKEN_NONE instead
+//that is everything up to the character the error was found at and any word it starts, such as a whole malformed number,
+//so like any other token whether it is an error never depends on text past its end
+static const char* scanTokenTolerantly(const Tokeniser* tokeniser, CompilationUnit* compilation_unit, Token* token, const char* position) {
+	const char* token_end = scanTokenSpeculatively(tokeniser, &compilation_unit->token_list, token, position);
+	if (token_end == NULL) {
+		token->type = TOKEN_NONE;
+		token->offset_in_source = position - tokeniser->source;
+		token->payload = 0;
+
+		token_end = position;
+		while (characterClass(*token_end) == CHARACTER_DIGIT || characterClass(*token_end) == CHARACTER_LETTER || *token_end == '.') {
+			++token_end;
+		}
+		if (token_end <= speculative_failure_cause) token_end = speculative_failure_cause + 1;
+		if (token_end > tokeniser->source_end) token_end = tokeniser->source_end;
+		return token_end > position ? token_end : position + 1;
 	}
-	fseek(source, -1, SEEK_CUR);
-	token->length_in_source = ftell(source) - token->offset_in_source;
 
-	//create buffer of identifier/keyword text
-	fseek(source, token->offset_in_source, SEEK_SET);
-	char buffer[token->length_in_source];
-	fread(buffer, sizeof(char), token->length_in_source, source);
+	//speculative identifiers hold their length
+	if (token->type == TOKEN_IDENTIFIER) {
+		token->payload = compilationUnit_getOrAddIdentifierIndex(compilation_unit, position, token->payload);
+	}
+	return token_end;
+}
 
-	//test if a keyword
-	token->type = findInKeywordTable(buffer, token->length_in_source);
-	if (token->type != TOKEN_NONE) return; //if its a keyword we are done
+//lines starting after the edit are moved and only the inserted text is scanned for new ones
+static void updateLineStarts(const Tokeniser* tokeniser, TokenList* token_list, size_t edit_offset, size_t removed_length, size_t inserted_length) {
+	//lines starting at or before the edit are unchanged, line_starts[0] is always 0 so at least one is
+	size_t low = 1;
+	size_t high = token_list->line_count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (token_list->line_starts[middle] <= edit_offset) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	size_t kept_count = low;
 
-	//we can now assume its an identifier
-	token->type = TOKEN_IDENTIFIER;
-	token->data.identifier = malloc((token->length_in_source + 1) * sizeof(char));
-	if (token->data.identifier == NULL) {
-		printf("ERROR: Failed to allocate memory for token identifier!\n");
+	//lines starting in the removed text are gone, set the rest aside while the inserted text is scanned
+	size_t moved_index = kept_count;
+	while (moved_index < token_list->line_count && token_list->line_starts[moved_index] <= edit_offset + removed_length) {
+		++moved_index;
+	}
+	size_t moved_count = token_list->line_count - moved_index;
+	uint32_t* moved_line_starts = malloc(moved_count * sizeof(uint32_t) + 1);
+	if (moved_line_starts == NULL) {
+		printf("ERROR: Failed to allocate memory for %zu line starts!\n", moved_count);
 		exit(1);
 	}
-	memccpy(token->data.identifier, buffer, sizeof(char), token->length_in_source);
-	token->data.identifier[token->length_in_source] = '\0';
-}
+	memcpy(moved_line_starts, token_list->line_starts + moved_index, moved_count * sizeof(uint32_t));
 
-static Token getToken(size_t search_index) {
-	fseek(source, search_index, SEEK_SET);
-	skipWhitespace();
+	token_list->line_count = kept_count;
+	addLineStarts(tokeniser, token_list, tokeniser->source + edit_offset, tokeniser->source + edit_offset + inserted_length);
 
-	//initialise token
-	Token token;
-	token.type = TOKEN_NONE; //default, will be overwritten
-	token.offset_in_source = ftell(source);
-	token.length_in_source = 1; //default, will be overwritten
-	token.line_number = line_number;
-	token.column_number = column_number;
-	memset(&token.data, 0, sizeof(token.data)); //default, will be overwritten
+	token_list->line_starts = ensureListCapacity(
+		token_list->line_starts,
+		&token_list->line_capacity,
+		token_list->line_count + moved_count,
+		sizeof(uint32_t)
+	);
+	for (size_t i = 0; i < moved_count; ++i) {
+		token_list->line_starts[token_list->line_count + i] = moved_line_starts[i] + inserted_length - removed_length;
+	}
+	token_list->line_count += moved_count;
+	free(moved_line_starts);
+}
 
-	//test eof
-	if (feof(source)) {
-		token.type = TOKEN_EOF;
-		token.length_in_source = 0;
-		return token;
+//replaced tokens leave their side table entries behind, the tables are rebuilt from the tokens left once the dead entries
+//outnumber the live ones, so a list that is edited forever stays within about twice the size of one lexed from scratch
+//small tables are left alone so short edit sessions never pay for a rebuild
+#define SIDE_TABLE_COMPACT_ENTRIES 1024
+#define SIDE_TABLE_COMPACT_BYTES (64 * 1024)
+
+//new list holding the elements at the given indices in order, the old one is freed
+static void* compactList(void* list, size_t* count, size_t* capacity, const uint32_t* kept_indices, size_t kept_count, size_t element_size) {
+	size_t new_capacity = 0;
+	char* new_list = ensureListCapacity(NULL, &new_capacity, kept_count, element_size);
+	for (size_t i = 0; i < kept_count; ++i) {
+		memcpy(new_list + i * element_size, (char*)list + kept_indices[i] * element_size, element_size);
 	}
+	free(list);
+	*count = kept_count;
+	*capacity = new_capacity;
+	return new_list;
+}
 
-	char first_char = fgetc(source);
+static void compactSideTables(TokenList* token_list) {
+	size_t live_entry_count = 0;
+	size_t live_string_data_length = 0;
+	for (size_t i = 0; i < token_list->token_count; ++i) {
+		switch (token_list->tokens[i].type) {
+			case TOKEN_INTEGER_LITERAL: case TOKEN_REAL_LITERAL: ++live_entry_count; break;
+			case TOKEN_STRING_LITERAL:
+			++live_entry_count;
+			live_string_data_length += token_list->strings[token_list->tokens[i].payload].length;
+			break;
 
-	//test number literal
-	if (isdigit(first_char)) {
-		getNumberLiteral(&token, first_char);
-		column_number += token.length_in_source;
-		return token;
+			default: break;
+		}
+	}
+	size_t dead_entry_count = token_list->integer_count + token_list->real_count + token_list->string_count - live_entry_count;
+	size_t dead_string_data_length = token_list->string_data_length - live_string_data_length;
+	bool entries_wasted = dead_entry_count > live_entry_count && dead_entry_count >= SIDE_TABLE_COMPACT_ENTRIES;
+	bool bytes_wasted = dead_string_data_length > live_string_data_length && dead_string_data_length >= SIDE_TABLE_COMPACT_BYTES;
+	if (!entries_wasted && !bytes_wasted) return;
+
+	//every table is rebuilt in token order and the payloads renumbered to match
+	size_t kept_capacity = 0;
+	uint32_t* kept_integers = ensureListCapacity(NULL, &kept_capacity, live_entry_count, sizeof(uint32_t));
+	kept_capacity = 0;
+	uint32_t* kept_reals = ensureListCapacity(NULL, &kept_capacity, live_entry_count, sizeof(uint32_t));
+	kept_capacity = 0;
+	uint32_t* kept_strings = ensureListCapacity(NULL, &kept_capacity, live_entry_count, sizeof(uint32_t));
+	size_t kept_integer_count = 0;
+	size_t kept_real_count = 0;
+	size_t kept_string_count = 0;
+	for (size_t i = 0; i < token_list->token_count; ++i) {
+		Token* token = token_list->tokens + i;
+		switch (token->type) {
+			case TOKEN_INTEGER_LITERAL: kept_integers[kept_integer_count] = token->payload; token->payload = kept_integer_count++; break;
+			case TOKEN_REAL_LITERAL: kept_reals[kept_real_count] = token->payload; token->payload = kept_real_count++; break;
+			case TOKEN_STRING_LITERAL: kept_strings[kept_string_count] = token->payload; token->payload = kept_string_count++; break;
+			default: break;
+		}
 	}
 
-	//test string literal
-	if (first_char == '"') {
-		getStringLiteral(&token);
-		column_number += token.length_in_source;
-		return token;
+	token_list->integers = compactList(token_list->integers, &token_list->integer_count, &token_list->integer_capacity, kept_integers, kept_integer_count, sizeof(uint64_t));
+	token_list->reals = compactList(token_list->reals, &token_list->real_count, &token_list->real_capacity, kept_reals, kept_real_count, sizeof(double));
+	token_list->strings = compactList(token_list->strings, &token_list->string_count, &token_list->string_capacity, kept_strings, kept_string_count, sizeof(TokenString));
+
+	//string text is moved along with its entries
+	size_t string_data_capacity = 0;
+	char* string_data = ensureListCapacity(NULL, &string_data_capacity, live_string_data_length, sizeof(char));
+	size_t string_data_length = 0;
+	for (size_t i = 0; i < token_list->string_count; ++i) {
+		TokenString* string = token_list->strings + i;
+		memcpy(string_data + string_data_length, token_list->string_data + string->offset, string->length);
+		string->offset = string_data_length;
+		string_data_length += string->length;
 	}
+	free(token_list->string_data);
+	token_list->string_data = string_data;
+	token_list->string_data_length = string_data_length;
+	token_list->string_data_capacity = string_data_capacity;
+
+	free(kept_integers);
+	free(kept_reals);
+	free(kept_strings);
+}
+
+TokenListEdit tokeniser_retokenise(
+	Tokeniser* tokeniser,
+	CompilationUnit* compilation_unit,
+	size_t edit_offset,
+	size_t removed_length,
+	size_t inserted_length
+) {
+	TokenList* token_list = &compilation_unit->token_list;
+
+	//nothing to reuse yet
+	if (token_list->tokens == NULL) {
+		beginTokenising(tokeniser, compilation_unit);
+	} else {
+		if (compilation_unit->source_length > UINT32_MAX) {
+			printf("ERROR: Source file is larger than the %" PRIu32 " byte limit!\n", UINT32_MAX);
+			exit(1);
+		}
 
-	//test character literal
-	if (first_char == '\'') {
-		getCharacterLiteral(&token);
-		column_number += token.length_in_source;
-		return token;
+		tokeniser->source = compilation_unit->source;
+		tokeniser->source_end = compilation_unit->source + compilation_unit->source_length;
+		tokeniser->source_base_offset = 0;
+
+		token_list->source = compilation_unit->source;
+		token_list->source_length = compilation_unit->source_length;
+		updateLineStarts(tokeniser, token_list, edit_offset, removed_length, inserted_length);
 	}
 
-	//test variable size types
-	getVariableSizeTypeIdentifier(&token, first_char);
-	if (token.type != TOKEN_NONE) {
-		column_number += token.length_in_source;
-		return token;
+	//find the first old token starting at or after the edit
+	size_t old_token_count = token_list->token_count;
+	size_t low = 0;
+	size_t high = old_token_count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (token_list->tokens[middle].offset_in_source < edit_offset) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
 	}
+	//the token before may run into the edit and the one before that may have looked ahead into it, so start there
+	size_t first_token = low > 2 ? low - 2 : 0;
+	const char* position = tokeniser->source;
+	if (low > 2) position += token_list->tokens[first_token].offset_in_source;
+
+	//lex until back in step with the old tokens after the edit
+	Token* new_tokens = NULL;
+	size_t new_token_count = 0;
+	size_t new_token_capacity = 0;
+	size_t old_index = first_token;
+	size_t edit_end = edit_offset + inserted_length;
+	while (true) {
+		position = skipWhitespace(position);
+		size_t offset = position - tokeniser->source;
+
+		if (offset >= edit_end) {
+			size_t old_offset = offset - inserted_length + removed_length;
+			while (old_index < old_token_count && token_list->tokens[old_index].offset_in_source < old_offset) {
+				++old_index;
+			}
+			if (old_index < old_token_count && token_list->tokens[old_index].offset_in_source == old_offset) break;
+		}
+
+		Token token;
+		position = scanTokenTolerantly(tokeniser, compilation_unit, &token, position);
+		new_tokens = ensureListCapacity(new_tokens, &new_token_capacity, new_token_count + 1, sizeof(Token));
+		new_tokens[new_token_count] = token;
+		++new_token_count;
 
-	//test identifier or keyword
-	if (isalpha(first_char) || first_char == '_') {
-		getIdentifierOrKeyword(&token);
-		column_number += token.length_in_source;
-		return token;
+		if (token.type == TOKEN_EOF) {
+			old_index = old_token_count;
+			break;
+		}
 	}
+	tokeniser->scan_position = position;
 
-	//test punctuation (operators and similar)
-	char buffer[3];
-	fseek(source, token.offset_in_source, SEEK_SET);
-	fread(buffer, sizeof(buffer[0]), sizeof(buffer) / sizeof(buffer[0]), source);
-	Punctuation punctuation = findInPunctuationTable(buffer);
-	if (punctuation.type != TOKEN_NONE) {
-		token.type = punctuation.type;
-		token.length_in_source = punctuation.length;
-		column_number += token.length_in_source;
-		return token;
+	//splice the new tokens in place of the old ones and move the rest
+	size_t moved_count = old_token_count - old_index;
+	token_list->tokens = ensureListCapacity(
+		token_list->tokens,
+		&token_list->token_capacity,
+		first_token + new_token_count + moved_count,
+		sizeof(Token)
+	);
+	Token* moved_tokens = token_list->tokens + first_token + new_token_count;
+	memmove(moved_tokens, token_list->tokens + old_index, moved_count * sizeof(Token));
+	for (size_t i = 0; i < moved_count; ++i) {
+		moved_tokens[i].offset_in_source = moved_tokens[i].offset_in_source + inserted_length - removed_length;
 	}
+	if (new_token_count > 0) memcpy(token_list->tokens + first_token, new_tokens, new_token_count * sizeof(Token));
+	token_list->token_count = first_token + new_token_count + moved_count;
+	free(new_tokens);
 
-	//return erroneous token
-	return token;
+	//a delimiter anywhere may now match differently
+	matchDelimiters(token_list);
+	compactSideTables(token_list);
+
+	return (TokenListEdit){first_token, old_index - first_token, new_token_count};
+}
+
+void tokeniser_setTokens(Tokeniser* tokeniser, const TokenList* token_list) {
+	tokeniser->token_list = token_list;
+	tokeniser->current_index = 0;
 }
 
-void tokeniserSetSource(FILE* new_source) {
-	source = new_source;
+const TokenList* tokeniser_currentTokenList(const Tokeniser* tokeniser) {
+	return tokeniser->token_list;
+}
 
-	//reset state
-	line_number = 1;
-	column_number = 1;
+const Token* tokeniser_currentToken(const Tokeniser* tokeniser) {
+	return tokeniser->token_list->tokens + tokeniser->current_index;
+}
+
+const Token* tokeniser_nextToken(const Tokeniser* tokeniser) {
+	//final token is always eof, stay on it
+	if (tokeniser->current_index + 1 >= tokeniser->token_list->token_count) return tokeniser_currentToken(tokeniser);
+	return tokeniser->token_list->tokens + tokeniser->current_index + 1;
+}
+
+TokenType tokeniser_currentTokenType(const Tokeniser* tokeniser) {
+	return tokeniser_currentToken(tokeniser)->type;
+}
+
+TokenType tokeniser_nextTokenType(const Tokeniser* tokeniser) {
+	return tokeniser_nextToken(tokeniser)->type;
+}
+
+void tokeniser_incrementToken(Tokeniser* tokeniser) {
+	if (tokeniser->current_index + 1 < tokeniser->token_list->token_count) ++tokeniser->current_index;
+}
+
+size_t tokeniser_currentTokenIndex(const Tokeniser* tokeniser) {
+	return tokeniser->current_index;
+}
+
+void tokeniser_jumpToToken(Tokeniser* tokeniser, size_t token_index) {
+	//final token is always eof, stay on it
+	if (token_index >= tokeniser->token_list->token_count) token_index = tokeniser->token_list->token_count - 1;
+	tokeniser->current_index = token_index;
+}
+
+/*
+
+wrappers using the default tokeniser of the calling thread
+
+*/
+
+void tokenise(CompilationUnit* compilation_unit) {
+	tokeniser_tokenise(&default_tokeniser, compilation_unit);
+}
+
+void tokeniseParallel(CompilationUnit* compilation_unit, size_t thread_count) {
+	tokeniser_tokeniseParallel(&default_tokeniser, compilation_unit, thread_count);
+}
+
+TokenListEdit retokenise(
+	CompilationUnit* compilation_unit,
+	size_t edit_offset,
+	size_t removed_length,
+	size_t inserted_length
+) {
+	return tokeniser_retokenise(&default_tokeniser, compilation_unit, edit_offset, removed_length, inserted_length);
+}
 
-	//initialise tokens
-	current_token = getToken(0);
-	size_t next_token_search_index = current_token.offset_in_source + current_token.length_in_source;
-	next_token = getToken(next_token_search_index);
+void tokeniserSetTokens(const TokenList* new_token_list) {
+	tokeniser_setTokens(&default_tokeniser, new_token_list);
 }
 
-Token currentToken(void) {
-	return current_token;
+const TokenList* currentTokenList(void) {
+	return tokeniser_currentTokenList(&default_tokeniser);
 }
 
-Token nextToken(void) {
-	return next_token;
+const Token* currentToken(void) {
+	return tokeniser_currentToken(&default_tokeniser);
+}
+
+const Token* nextToken(void) {
+	return tokeniser_nextToken(&default_tokeniser);
+}
+
+TokenType currentTokenType(void) {
+	return tokeniser_currentTokenType(&default_tokeniser);
+}
+
+TokenType nextTokenType(void) {
+	return tokeniser_nextTokenType(&default_tokeniser);
 }
 
 void incrementToken(void) {
-	//free string literal token data
-	if (current_token.type == TOKEN_STRING_LITERAL) {
-		free(current_token.data.string.text);
-	}
-	//free token identifier
-	if (current_token.type == TOKEN_IDENTIFIER) {
-		free(current_token.data.identifier);
-	}
-	//update tokens
-	current_token = next_token;
-	size_t next_token_search_index = current_token.offset_in_source + current_token.length_in_source;
-	next_token = getToken(next_token_search_index);
+	tokeniser_incrementToken(&default_tokeniser);
+}
+
+size_t currentTokenIndex(void) {
+	return tokeniser_currentTokenIndex(&default_tokeniser);
+}
+
+void jumpToToken(size_t token_index) {
+	tokeniser_jumpToToken(&default_tokeniser, token_index);
 }
@@ -1,13 +1,78 @@
 #pragma once
 
 #include <stddef.h>
-#include <stdio.h>
 
+#include "compilation_unit.h"
 #include "token.h"
 
-//must be called before other functions, resets state
-void tokeniserSetSource(FILE* new_source);
+//all state of one tokeniser, any number may be used at once on different threads
+//needs no setup, tokenise and set tokens initialise the parts they use
+typedef struct {
+	//lexing, source is followed by SOURCE_PADDING zero bytes so '\0' acts as a sentinel
+	const char* source;
+	const char* source_end;
+	const char* scan_position; //end of the most recently scanned token
+	size_t source_base_offset; //offset of source in the whole input, only nonzero when streaming through a window
 
-Token currentToken(void);
-Token nextToken(void);
+	//token list currently being parsed
+	const TokenList* token_list;
+	size_t current_index;
+} Tokeniser;
+
+//lexes the whole source of the compilation unit into its token list
+//the list always ends with a TOKEN_EOF token
+void tokeniser_tokenise(Tokeniser* tokeniser, CompilationUnit* compilation_unit);
+//same result as tokenise but lexes chunks of large sources on thread_count threads
+void tokeniser_tokeniseParallel(Tokeniser* tokeniser, CompilationUnit* compilation_unit, size_t thread_count);
+//tokens [first_token, first_token + removed_count) of a token list were replaced by [first_token, first_token + inserted_count)
+typedef struct {
+	size_t first_token;
+	size_t removed_count;
+	size_t inserted_count;
+} TokenListEdit;
+
+//updates the token list after removed_length bytes at edit_offset of the source were replaced by inserted_length new ones,
+//only tokens near the edit are lexed again and the rest are moved, a token list not yet lexed is lexed whole
+//errors never stop lexing, text that starts no valid token becomes a TOKEN_NONE token
+TokenListEdit tokeniser_retokenise(
+	Tokeniser* tokeniser,
+	CompilationUnit* compilation_unit,
+	size_t edit_offset,
+	size_t removed_length,
+	size_t inserted_length
+);
+
+//must be called before other functions below, moves back to the first token
+void tokeniser_setTokens(Tokeniser* tokeniser, const TokenList* token_list);
+const TokenList* tokeniser_currentTokenList(const Tokeniser* tokeniser);
+
+//pointers stay valid until the token list is destroyed
+const Token* tokeniser_currentToken(const Tokeniser* tokeniser);
+const Token* tokeniser_nextToken(const Tokeniser* tokeniser);
+TokenType tokeniser_currentTokenType(const Tokeniser* tokeniser);
+TokenType tokeniser_nextTokenType(const Tokeniser* tokeniser);
+void tokeniser_incrementToken(Tokeniser* tokeniser);
+//index into the token list, jumping to a matching delimiter from its payload skips everything between
+size_t tokeniser_currentTokenIndex(const Tokeniser* tokeniser);
+void tokeniser_jumpToToken(Tokeniser* tokeniser, size_t token_index);
+
+//same as above on a default tokeniser, each thread has its own
+void tokenise(CompilationUnit* compilation_unit);
+void tokeniseParallel(CompilationUnit* compilation_unit, size_t thread_count);
+TokenListEdit retokenise(
+	CompilationUnit* compilation_unit,
+	size_t edit_offset,
+	size_t removed_length,
+	size_t inserted_length
+);
+
+void tokeniserSetTokens(const TokenList* new_token_list);
+const TokenList* currentTokenList(void);
+
+const Token* currentToken(void);
+const Token* nextToken(void);
+TokenType currentTokenType(void);
+TokenType nextTokenType(void);
 void incrementToken(void);
+size_t currentTokenIndex(void);
+void jumpToToken(size_t token_index);